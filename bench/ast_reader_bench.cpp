@@ -0,0 +1,158 @@
+// Text AST reader throughput: readASTFromFile over a large parser-output.ast style dump, against
+// the cost of just splitting the same file into std::string lines with getline (what the reader
+// paid before it parsed anything), and buildAST lowering the parse tree the dump was written from.
+// The two must give the same tree.
+// Build and run with `make bench`.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../src/include/Parser.h"
+#include "../src/include/ParseArena.h"
+#include "../src/include/parser_utils.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double bestSeconds(int runs, F&& body) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = Clock::now();
+        body();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+double megabytesPerSecond(size_t bytes, double seconds) {
+    return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0;
+}
+
+// A parse tree the way the grammar builds one: functions of declarations, calls, loops and
+// arithmetic, 20 dump lines each, until its dump is about bytes long
+ProgramNode* makeProgram(ParseArena& arena, size_t bytes) {
+    auto expression = [&](const char* type, std::string_view value, std::initializer_list<ParseNode*> children = {}) {
+        ParseNode* node = arena.make<ParseNode>(type, value);
+        node->children.assign(children.begin(), children.end());
+        return node;
+    };
+    auto statement = [&](const char* type, std::string_view value, std::string_view name = "", std::string_view typeHint = "") {
+        StatementNode* node = arena.make<StatementNode>();
+        node->type = type;
+        node->value = value;
+        node->name = name;
+        node->type_hint = typeHint;
+        return node;
+    };
+    const size_t unitBytes = 540;
+
+    ProgramNode* program = arena.make<ProgramNode>();
+    for (size_t unit = 0; unit * unitBytes < bytes; ++unit) {
+        FunctionNode* function = arena.make<FunctionNode>();
+        function->return_type = "int";
+        function->name = "function_" + std::to_string(unit);
+
+        StatementNode* declarations = statement("LocalDeclaration", "int declarations");
+        StatementNode* count = statement("VarDecl", "int count = 1", "count", "int");
+        count->children.push_back(expression("Number", "1"));
+        declarations->statements.push_back(count);
+        declarations->statements.push_back(statement("VarDecl", "int total", "total", "int"));
+
+        StatementNode* call = statement("Call", "printf(\"value %d\n\", count)", "printf");
+        call->children.push_back(expression("String", "\"value %d\n\""));
+        call->children.push_back(expression("Identifier", "count"));
+
+        StatementNode* loop = statement("While", "count < 100");
+        StatementNode* assignment = statement("Assignment", "total = total + count", "total");
+        assignment->children.push_back(expression("Add", "total + count", {expression("Identifier", "total"), expression("Identifier", "count")}));
+        loop->statements.push_back(assignment);
+        loop->children.push_back(expression("Less", "count < 100", {expression("Identifier", "count"), expression("Number", "100")}));
+
+        StatementNode* result = statement("Return", "total % 7");
+        result->children.push_back(expression("Modulo", "total % 7", {expression("Identifier", "total"), expression("Number", "7")}));
+
+        function->statements.assign({declarations, call, loop, result});
+        program->functions.push_back(function);
+    }
+    return program;
+}
+
+bool sameTree(ASTRef a, ASTRef b) {
+    if (a.type() != b.type() || a.value() != b.value() || a.typeHint() != b.typeHint() ||
+        a.callString() != b.callString() || a.line() != b.line() || a.childCount() != b.childCount()) {
+        std::cerr << "Node at line " << a.line() << " differs: '" << a.value() << "' against '" << b.value() << "'\n";
+        return false;
+    }
+    for (ASTRef x = a.child(0), y = b.child(0); x; x = x.nextSibling(), y = y.nextSibling()) {
+        if (!sameTree(x, y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 8;
+    StringPool pool;
+    StringPool::Scope scope(pool);
+    ParseArena arena;
+    const ProgramNode& program = *makeProgram(arena, megabytes << 20);
+    std::string dump;
+    write_parse_tree(dump, program);
+    size_t lines = std::count(dump.begin(), dump.end(), '\n');
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "uctool-bench-parser-output.ast";
+    std::ofstream(path, std::ios::binary) << dump;
+
+    size_t nodes = 0;
+    double getlineSeconds = bestSeconds(5, [&] {
+        std::ifstream file(path);
+        std::string line;
+        size_t count = 0;
+        while (std::getline(file, line)) {
+            count++;
+        }
+        nodes = count;
+    });
+    // Best of 5 as well, but each run's tree is freed outside the timed region
+    AST ast;
+    double readerSeconds = 1e30;
+    for (int i = 0; i < 5; ++i) {
+        ast = AST();
+        auto start = Clock::now();
+        ast = readASTFromFile(path.string());
+        readerSeconds = std::min(readerSeconds, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    nodes = ast.size();
+    std::filesystem::remove(path);
+    AST built;
+    double builderSeconds = 1e30;
+    for (int i = 0; i < 5; ++i) {
+        built = AST();
+        auto start = Clock::now();
+        built = buildAST(program);
+        builderSeconds = std::min(builderSeconds, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    std::printf("\nText AST reader (%zu MB, %zu lines, best of 5)\n", dump.size() >> 20, lines);
+    std::printf("%-28s %10.0f MB/s\n", "getline only", megabytesPerSecond(dump.size(), getlineSeconds));
+    std::printf("%-28s %10.0f MB/s %10.1f M nodes/s\n", "readASTFromFile", megabytesPerSecond(dump.size(), readerSeconds),
+                nodes / readerSeconds / 1e6);
+    std::printf("%-28s %10s      %10.1f M nodes/s\n", "buildAST (no dump)", "", built.size() / builderSeconds / 1e6);
+    if (nodes != lines) {
+        std::cerr << "Error: read " << nodes << " nodes from a " << lines << "-line dump\n";
+        return 1;
+    }
+    if (!sameTree(ast.root(), built.root())) {
+        std::cerr << "Error: buildAST and the text reader disagree\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,301 @@
+// Lexer throughput: SIMD scan kernels against the scalar reference, the FAST (kernel-assisted)
+// flex scanner against the pure flex DFA, chunked parallel lexing, and incremental re-lexing of
+// small edits against lexing the whole file again, all on the same inputs.
+// Build and run with `make bench`.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/include/frontend_context.hpp"
+#include "../src/include/ScanKernels.h"
+#include "../src/include/IncrementalLexer.h"
+#include "../src/include/HeaderCache.h"
+
+extern bool lexSourceFile(FrontendContext& ctx, const char* filename);
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double bestSeconds(int runs, F&& body) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = Clock::now();
+        body();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+double megabytesPerSecond(size_t bytes, double seconds) {
+    return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0;
+}
+
+std::string repeat(const std::string& unit, size_t bytes) {
+    std::string out;
+    out.reserve(bytes + unit.size());
+    while (out.size() < bytes) out += unit;
+    return out;
+}
+
+// Inputs shaped after the runs the kernels target
+struct Corpus {
+    const char* name;
+    std::string text;
+};
+
+std::vector<Corpus> makeCorpora(size_t bytes) {
+    std::string longName(48, 'x');
+    return {
+        {"comment-heavy", repeat("/* A block comment that goes on for a while,\n   over more than one line. */\n"
+                                 "int value; // trailing line comment explaining the value above\n", bytes)},
+        {"long-identifiers", repeat("int " + longName + "_count = " + longName + "_total + "
+                                    + longName + "_offset;\n", bytes)},
+        {"string-literals", repeat("printf(\"a fairly long string literal with an \\\"escape\\\" in it\\n\");\n", bytes)},
+        {"inactive-regions", repeat("#ifdef UNSET_OPTION\nint disabled_feature(int a, int b) {\n    return a * b + 42;\n}\n"
+                                    "#else\nint enabled;\n#endif\n", bytes)},
+        {"indented-code", repeat("int main() {\n        int a = 10;\n        if (a > 5) {\n                a = a + 1;\n        }\n        return a;\n}\n", bytes)},
+    };
+}
+
+void benchKernels(const std::vector<Corpus>& corpora) {
+    std::vector<const ScanKernels*> variants = {&scalarScanKernels()};
+#if defined(__x86_64__) || defined(__i386__)
+    variants.push_back(&sse2ScanKernels());
+    if (avx2ScanKernels()) variants.push_back(avx2ScanKernels());
+#endif
+    const std::string blanks = repeat("        \t\r\n", 1 << 20);
+    const std::string identifier = repeat("abcdefghijklmnopqrstuvwxyz_0123456789", 1 << 20);
+    const std::string& comment = corpora[0].text;
+
+    std::printf("\nKernels (MB/s, best of 5)\n");
+    std::printf("%-10s %12s %12s %12s %12s %12s\n", "variant", "blanks", "identifier", "line-end", "comment-end", "newlines");
+    for (const ScanKernels* k : variants) {
+        volatile size_t sink = 0;
+        auto run = [&](const std::string& s, auto&& call) {
+            const char* end = s.data() + s.size();
+            return megabytesPerSecond(s.size(), bestSeconds(5, [&] { sink += call(s.data(), end); }));
+        };
+        double b = run(blanks, [&](const char* p, const char* e) { return size_t(k->skipBlanks(p, e) - p); });
+        double i = run(identifier, [&](const char* p, const char* e) { return size_t(k->skipIdentifier(p, e) - p); });
+        double l = run(identifier, [&](const char* p, const char* e) { return size_t(k->findByte(p, e, '\n') - p); });
+        double c = run(identifier, [&](const char* p, const char* e) { return size_t(k->findCommentEnd(p, e) != nullptr); });
+        double n = run(comment, [&](const char* p, const char* e) { return k->countNewlines(p, e); });
+        std::printf("%-10s %12.0f %12.0f %12.0f %12.0f %12.0f\n", k->name, b, i, l, c, n);
+    }
+}
+
+// Random buffers checked against the scalar kernels at every start offset. Each is a long run of
+// one byte with a few bytes the kernels stop on scattered through it, plus one quote, escape or
+// comment end planted across a 16- or 32-byte block edge.
+bool sameKernels() {
+    std::vector<const ScanKernels*> variants;
+#if defined(__x86_64__) || defined(__i386__)
+    variants.push_back(&sse2ScanKernels());
+    if (avx2ScanKernels()) variants.push_back(avx2ScanKernels());
+#endif
+    const ScanKernels& reference = scalarScanKernels();
+    const std::string fillers = " a\\*x";
+    const std::string stops = " \t\r\n\\\"'*/aZ_9-\x80\xff";
+    const std::vector<std::string> planted = {"*/", "\\\n", "\\\"", "\\\\\"", "\"", "'", "\\'", "\\"};
+    std::mt19937 random(7);
+    for (int round = 0; round < 20000; ++round) {
+        std::string text(1 + random() % 100, fillers[random() % fillers.size()]);
+        for (size_t n = random() % (text.size() / 8 + 2); n > 0; --n) {
+            text[random() % text.size()] = stops[random() % stops.size()];
+        }
+        const std::string& sequence = planted[random() % planted.size()];
+        size_t edge = 16 * (1 + random() % 6);
+        size_t at = edge - random() % sequence.size();
+        if (at + sequence.size() <= text.size()) text.replace(at, sequence.size(), sequence);
+
+        const char* end = text.data() + text.size();
+        char byte = stops[random() % stops.size()];
+        for (const char* p = text.data(); p <= end; ++p) {
+            for (const ScanKernels* k : variants) {
+                const char* differs = nullptr;
+                if (k->skipBlanks(p, end) != reference.skipBlanks(p, end)) differs = "skipBlanks";
+                else if (k->skipIdentifier(p, end) != reference.skipIdentifier(p, end)) differs = "skipIdentifier";
+                else if (k->findByte(p, end, byte) != reference.findByte(p, end, byte)) differs = "findByte";
+                else if (k->findCommentEnd(p, end) != reference.findCommentEnd(p, end)) differs = "findCommentEnd";
+                else if (k->findStringEnd(p, end, '"') != reference.findStringEnd(p, end, '"') ||
+                         k->findStringEnd(p, end, '\'') != reference.findStringEnd(p, end, '\'')) differs = "findStringEnd";
+                else if (k->countNewlines(p, end) != reference.countNewlines(p, end)) differs = "countNewlines";
+                if (differs) {
+                    std::cerr << k->name << " " << differs << " differs from scalar at offset " << (p - text.data())
+                              << " of a " << text.size() << "-byte input (round " << round << ")\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool sameTokens(const FrontendContext& a, const FrontendContext& b) {
+    if (a.tokens.size() != b.tokens.size() || a.unknown_tokens.size() != b.unknown_tokens.size()) return false;
+    for (size_t i = 0; i < a.tokens.size(); ++i) {
+        const Tokens& x = a.tokens[i];
+        const Tokens& y = b.tokens[i];
+        if (x.kind != y.kind || x.offset != y.offset || x.file != y.file || a.strings.view(x.lexeme) != b.strings.view(y.lexeme)) {
+            std::cerr << "Token " << i << " differs at line " << a.position(x.offset).line << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool benchScanner(const std::vector<Corpus>& corpora) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    bool identical = true;
+    std::printf("\nScanner (MB/s, best of 5, kernels: %s, %u threads for parallel)\n", scanKernels().name,
+                std::thread::hardware_concurrency());
+    std::printf("%-18s %10s %12s %12s %9s %12s %9s\n", "input", "tokens", "pure flex", "fast", "speedup", "parallel", "speedup");
+    for (const Corpus& corpus : corpora) {
+        std::filesystem::path path = dir / (std::string("uctool-bench-") + corpus.name + ".c");
+        std::ofstream(path, std::ios::binary) << corpus.text;
+
+        FrontendContext pure;
+        pure.use_scan_kernels = false;
+        pure.lex_jobs = 1;
+        FrontendContext fast;
+        fast.lex_jobs = 1;
+        FrontendContext parallel;
+        double pureSeconds = bestSeconds(5, [&] { lexSourceFile(pure, path.c_str()); });
+        double fastSeconds = bestSeconds(5, [&] { lexSourceFile(fast, path.c_str()); });
+        double parallelSeconds = bestSeconds(5, [&] { lexSourceFile(parallel, path.c_str()); });
+        identical = sameTokens(pure, fast) && identical;
+        identical = sameTokens(fast, parallel) && identical;
+
+        std::printf("%-18s %10zu %12.0f %12.0f %8.2fx %12.0f %8.2fx\n", corpus.name, fast.tokens.size(),
+                    megabytesPerSecond(corpus.text.size(), pureSeconds),
+                    megabytesPerSecond(corpus.text.size(), fastSeconds), pureSeconds / fastSeconds,
+                    megabytesPerSecond(corpus.text.size(), parallelSeconds), fastSeconds / parallelSeconds);
+        std::filesystem::remove(path);
+    }
+    return identical;
+}
+
+// Single-byte edits at random places, each brought up to date incrementally; the result is
+// checked against lexing the edited text from scratch
+bool benchIncremental(const Corpus& corpus) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "uctool-bench-incremental.c";
+    std::ofstream(path, std::ios::binary) << corpus.text;
+    FrontendContext live;
+    live.lex_jobs = 1;
+    IncrementalLexer lexer(live);
+    lexer.open(path.c_str());
+    double fullSeconds = bestSeconds(3, [&] { FrontendContext fresh; fresh.lex_jobs = 1; lexSourceFile(fresh, path.c_str()); });
+
+    const int edits = 1000;
+    std::mt19937 random(42);
+    size_t relexedBytes = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < edits; ++i) {
+        uint32_t offset = random() % live.source.size();
+        SourceEdit edit = i % 2 == 0 ? SourceEdit{offset, 0, "x"} : SourceEdit{offset, 1, " "};
+        lexer.apply(edit);
+        relexedBytes += lexer.lastStats().relexEnd - lexer.lastStats().relexBegin;
+    }
+    double incrementalSeconds = std::chrono::duration<double>(Clock::now() - start).count() / edits;
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << live.source.view();
+    FrontendContext reference;
+    reference.lex_jobs = 1;
+    lexSourceFile(reference, path.c_str());
+    std::filesystem::remove(path);
+
+    std::printf("\nIncremental re-lex (%s, %d one-byte edits)\n", corpus.name, edits);
+    std::printf("%-28s %12.1f us\n", "full lex", fullSeconds * 1e6);
+    std::printf("%-28s %12.1f us\n", "incremental, per edit", incrementalSeconds * 1e6);
+    std::printf("%-28s %12.1f bytes\n", "re-lexed, per edit", double(relexedBytes) / edits);
+    return sameTokens(reference, live);
+}
+
+// Translation units that share one guarded header, each including it twice: lexed with the
+// header cache emptied before every unit, then with it kept warm across units
+bool benchIncludes(const Corpus& corpus) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "uctool-bench-includes";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "common.h", std::ios::binary) << "#ifndef COMMON_H\n#define COMMON_H\n"
+                                                      << corpus.text.substr(0, 256 << 10) << "#endif\n";
+    const int units = 32;
+    std::vector<std::string> paths;
+    for (int i = 0; i < units; ++i) {
+        paths.push_back((dir / ("unit" + std::to_string(i) + ".c")).string());
+        std::ofstream(paths.back(), std::ios::binary) << "#include \"common.h\"\n#include \"common.h\"\n"
+                                                      << "int unit" << i << "() {\n    return " << i << ";\n}\n";
+    }
+
+    FrontendContext cold;
+    cold.lex_jobs = 1;
+    double coldSeconds = bestSeconds(3, [&] {
+        for (const std::string& path : paths) {
+            HeaderCache::shared().clear();
+            cold.macros.clear();
+            lexSourceFile(cold, path.c_str());
+        }
+    });
+    FrontendContext warm;
+    warm.lex_jobs = 1;
+    HeaderCache::shared().clear();
+    double warmSeconds = bestSeconds(3, [&] {
+        for (const std::string& path : paths) {
+            warm.macros.clear();
+            lexSourceFile(warm, path.c_str());
+        }
+    });
+    HeaderCacheStats stats = HeaderCache::shared().stats();
+    // The units share their prelude, so after the first one writes it each loads the snapshot
+    FrontendContext snapshot;
+    snapshot.lex_jobs = 1;
+    snapshot.pch_path = (dir / "prelude.pch").string();
+    double snapshotSeconds = bestSeconds(3, [&] {
+        for (const std::string& path : paths) {
+            snapshot.macros.clear();
+            lexSourceFile(snapshot, path.c_str());
+        }
+    });
+    std::filesystem::remove_all(dir);
+
+    std::printf("\nIncludes (%d units sharing a %zu KiB guarded header)\n", units, size_t(256));
+    std::printf("%-28s %12.1f us\n", "per unit, cache cleared", coldSeconds / units * 1e6);
+    std::printf("%-28s %12.1f us\n", "per unit, cache warm", warmSeconds / units * 1e6);
+    std::printf("%-28s %12.1f us\n", "per unit, prelude snapshot", snapshotSeconds / units * 1e6);
+    std::printf("%-28s %12llu / %llu\n", "headers lexed / hits", (unsigned long long)stats.misses,
+                (unsigned long long)stats.hits);
+    std::printf("%-28s %12llu\n", "guard skips", (unsigned long long)stats.guardSkips);
+    return sameTokens(cold, warm) && sameTokens(cold, snapshot);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 8;
+    std::vector<Corpus> corpora = makeCorpora(megabytes << 20);
+    if (!sameKernels()) {
+        std::cerr << "Error: SIMD scan kernels disagree with the scalar ones\n";
+        return 1;
+    }
+    benchKernels(corpora);
+    if (!benchScanner(corpora)) {
+        std::cerr << "Error: pure flex, FAST and parallel scans produced different tokens\n";
+        return 1;
+    }
+    if (!benchIncremental(corpora.back())) {
+        std::cerr << "Error: incremental re-lexing drifted from a full scan\n";
+        return 1;
+    }
+    if (!benchIncludes(corpora.back())) {
+        std::cerr << "Error: cached, snapshot and freshly lexed headers produced different tokens\n";
+        return 1;
+    }
+    return 0;
+}
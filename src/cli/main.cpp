@@ -1,27 +1,28 @@
 // Entry point for CLI
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
 #include "../ai/llm_explainer.h"
+#include "../include/frontend_context.hpp"
+#include "../include/trace.hpp"
 
 // Forward declarations
-extern void performLexicalAnalysis(const char* filename);
-extern void performParsing();
-extern void runSemanticAnalysis(const char* filename);
-extern void runTACGeneration(const char* filename);
-extern void runTargetCodeGeneration(const char* filename);
-
-// Function to check if file exists
-bool fileExists(const std::string& path) {
-    return std::filesystem::exists(path);
-}
+extern void performLexicalAnalysis(FrontendContext& ctx, const char* filename, bool dump_tokens);
+extern std::string formatTokenTable(const FrontendContext& ctx);
+extern bool parseSource(FrontendContext& ctx, const char* filename);
+extern void performParsing(FrontendContext& ctx, const char* filename);
+extern const std::string& formatParseTree(FrontendContext& ctx);
+extern void runSemanticAnalysis(const ProgramNode& program, bool share_expressions);
+extern void runTACGeneration(const ProgramNode& program);
+extern void runTargetCodeGeneration(const ProgramNode& program);
 
 int main(int argc, char* argv[]) {
     if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <source_file> [--lexical] [--parse] [--semantic] [--intermediate] [--target] [--help]\n";
+        std::cerr << "Usage: " << argv[0] << " <source_file> [--lexical] [--parse] [--semantic] [--intermediate] [--target] [--dump-tokens] [--dump-ast] [--share-expressions] [--no-mmap] [--stream] [--pipeline] [--lex-jobs=N] [-I<dir>] [--pch=FILE] [--stats] [--verbose] [--trace[=lexer,parser,ast]] [--help]\n";
         return 1;
     }
 
@@ -32,6 +33,16 @@ int main(int argc, char* argv[]) {
     bool intermediate_mode = false;
     bool target_mode = false;
     bool help_mode = false;
+    bool dump_tokens = false;
+    bool dump_ast = false;
+    bool share_expressions = false;
+    bool map_source = true;
+    bool stream_tokens = false;
+    bool pipeline_tokens = false;
+    unsigned lex_jobs = 0;
+    bool show_stats = false;
+    std::vector<std::string> include_dirs;
+    std::string pch_path;
 
     // Parse command-line arguments, only allow --help at the end
     for (int i = 1; i < argc; ++i) {
@@ -45,6 +56,42 @@ int main(int argc, char* argv[]) {
             intermediate_mode = true;
         } else if (std::strcmp(argv[i], "--target") == 0) {
             target_mode = true;
+        } else if (std::strcmp(argv[i], "--dump-tokens") == 0) {
+            dump_tokens = true;
+        } else if (std::strcmp(argv[i], "--dump-ast") == 0) {
+            dump_ast = true;
+        } else if (std::strcmp(argv[i], "--share-expressions") == 0) {
+            share_expressions = true;
+        } else if (std::strcmp(argv[i], "--no-mmap") == 0) {
+            map_source = false;
+        } else if (std::strcmp(argv[i], "--stream") == 0) {
+            stream_tokens = true;
+        } else if (std::strcmp(argv[i], "--pipeline") == 0) {
+            pipeline_tokens = true;
+        } else if (std::strncmp(argv[i], "--lex-jobs=", 11) == 0) {
+            char* end = nullptr;
+            unsigned long jobs = std::strtoul(argv[i] + 11, &end, 10);
+            if (end == argv[i] + 11 || *end != '\0' || jobs > 1024) {
+                std::cerr << "Error: Invalid job count in '" << argv[i] << "'\n";
+                return 1;
+            }
+            lex_jobs = static_cast<unsigned>(jobs);
+        } else if (std::strncmp(argv[i], "-I", 2) == 0 && argv[i][2] != '\0') {
+            include_dirs.push_back(argv[i] + 2);
+        } else if (std::strncmp(argv[i], "--pch=", 6) == 0 && argv[i][6] != '\0') {
+            pch_path = argv[i] + 6;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            show_stats = true;
+        } else if (std::strcmp(argv[i], "--verbose") == 0) {
+            trace_config.level = TraceLevel::Info;
+        } else if (std::strcmp(argv[i], "--trace") == 0) {
+            trace_config.level = TraceLevel::Debug;
+        } else if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_config.level = TraceLevel::Debug;
+            if (!parse_trace_categories(argv[i] + 8, trace_config.categories)) {
+                std::cerr << "Error: Unknown trace category in '" << argv[i] << "' (expected lexer, parser, ast)\n";
+                return 1;
+            }
         } else if (std::strcmp(argv[i], "--help") == 0 && i == argc - 1) {
             help_mode = true;
         } else {
@@ -55,77 +102,80 @@ int main(int argc, char* argv[]) {
     // Check if at least one mode is specified
     if (!lexical_mode && !parse_mode && !semantic_mode && !intermediate_mode && !target_mode) {
         std::cerr << "Error: At least one of --lexical, --parse, --semantic, --intermediate, or --target is required\n";
-        std::cerr << "Usage: " << argv[0] << " <source_file> [--lexical] [--parse] [--semantic] [--intermediate] [--target] [--help]\n";
+        std::cerr << "Usage: " << argv[0] << " <source_file> [--lexical] [--parse] [--semantic] [--intermediate] [--target] [--dump-tokens] [--dump-ast] [--share-expressions] [--no-mmap] [--stream] [--pipeline] [--lex-jobs=N] [-I<dir>] [--pch=FILE] [--stats] [--verbose] [--trace[=lexer,parser,ast]] [--help]\n";
         return 1;
     }
 
     // Check if source file is provided
     if (source_file.empty()) {
         std::cerr << "Error: No input file specified\n";
-        std::cerr << "Usage: " << argv[0] << " <source_file> [--lexical] [--parse] [--semantic] [--intermediate] [--target] [--help]\n";
+        std::cerr << "Usage: " << argv[0] << " <source_file> [--lexical] [--parse] [--semantic] [--intermediate] [--target] [--dump-tokens] [--dump-ast] [--share-expressions] [--no-mmap] [--stream] [--pipeline] [--lex-jobs=N] [-I<dir>] [--pch=FILE] [--stats] [--verbose] [--trace[=lexer,parser,ast]] [--help]\n";
         return 1;
     }
 
     // Ensure temp directory exists
     std::filesystem::create_directory("../temp");
 
-    // The AST file used for semantic, intermediate, and target modes
-    const std::string ast_file = "../temp/parser-output.ast";
-
-    // Check if AST file exists for semantic, intermediate, or target modes
-    if ((semantic_mode || intermediate_mode || target_mode) && !fileExists(ast_file)) {
-        std::cerr << "Error: AST file not found at 'temp/parser-output.ast'. Please run with --parse first.\n";
-        return 1;
+    // Per-compilation frontend state (tokens, macros, parse tree) shared by the lexical and parse stages
+    FrontendContext frontend;
+    // The lexical help explains the complete token table, which streaming never holds
+    if (stream_tokens && help_mode && lexical_mode) {
+        std::cerr << "Warning: --stream is ignored with --lexical --help\n";
+        stream_tokens = false;
     }
+    // Streaming reads through stdio's fixed buffer. Flex writes into the buffer it scans, so a
+    // private mapping would turn every page it reaches into a copy, pinned by the lexemes borrowed
+    // from it, and resident memory would grow to the size of the file
+    frontend.map_source = map_source && !stream_tokens;
+    frontend.stream_tokens = stream_tokens;
+    frontend.pipeline_tokens = pipeline_tokens;
+    frontend.lex_jobs = lex_jobs;
+    frontend.include_dirs = include_dirs;
+    frontend.pch_path = pch_path;
+    frontend.dump_ast = dump_ast;
+    // One string pool for the whole compilation: token text, AST names, symbols and TAC operands
+    StringPool::Scope string_scope(frontend.strings);
 
     std::string stage, input_data, output_data;
     if (lexical_mode) {
-        performLexicalAnalysis(source_file.c_str());
+        performLexicalAnalysis(frontend, source_file.c_str(), dump_tokens);
         stage = "lexical";
-        // Read input and output for help
-        std::ifstream in_file(source_file);
-        std::stringstream in_buf;
-        in_buf << in_file.rdbuf();
-        input_data = in_buf.str();
-        std::ifstream out_file("../temp/lex-tokens.txt");
-        if (!out_file.is_open()) {
-            std::cerr << "Warning: Could not open 'temp/lex-tokens.txt' for AI explanation\n";
+        // Read input and output for help; the scanned source is still in memory when it was mapped
+        if (frontend.source.isOpen()) {
+            input_data = std::string(frontend.source.view());
+        } else {
+            std::ifstream in_file(source_file);
+            std::stringstream in_buf;
+            in_buf << in_file.rdbuf();
+            input_data = in_buf.str();
+        }
+        if (help_mode) {
+            output_data = formatTokenTable(frontend);
         }
-        std::stringstream out_buf;
-        out_buf << out_file.rdbuf();
-        output_data = out_buf.str();
     }
     if (parse_mode) {
-        performParsing();
+        // Tokens from --lexical are handed over in memory; no token file is read back
+        performParsing(frontend, source_file.c_str());
         stage = "parse";
         // Read input and output for help
-        std::ifstream in_file("../temp/lex-tokens.txt");
-        if (!in_file.is_open()) {
-            std::cerr << "Warning: Could not open 'temp/lex-tokens.txt' for AI explanation\n";
+        if (help_mode) {
+            input_data = formatTokenTable(frontend);
         }
-        std::stringstream in_buf;
-        in_buf << in_file.rdbuf();
-        input_data = in_buf.str();
-        std::ifstream out_file("../temp/parser-output.ast");
-        if (!out_file.is_open()) {
-            std::cerr << "Warning: Could not open 'temp/parser-output.ast' for AI explanation\n";
+        output_data = formatParseTree(frontend);
+    }
+    // The later stages take the parse tree in memory; without --parse, the source is parsed here
+    if ((semantic_mode || intermediate_mode || target_mode) && frontend.parse_result == nullptr) {
+        if (!parseSource(frontend, source_file.c_str())) {
+            std::cerr << "\nError: Could not build the AST for '" << source_file << "'\n";
+            return 1;
         }
-        std::stringstream out_buf;
-        out_buf << out_file.rdbuf();
-        output_data = out_buf.str();
     }
     if (semantic_mode) {
         std::cout << "Running semantic analysis on " << source_file << "...\n";
-        runSemanticAnalysis(ast_file.c_str());
+        runSemanticAnalysis(*frontend.parse_result, share_expressions);
         stage = "semantic";
         // Read input and output for help
-        std::ifstream in_file(ast_file);
-        if (!in_file.is_open()) {
-            std::cerr << "Warning: Could not open 'temp/parser-output.ast' for AI explanation\n";
-        }
-        std::stringstream in_buf;
-        in_buf << in_file.rdbuf();
-        input_data = in_buf.str();
+        input_data = formatParseTree(frontend);
         std::ifstream out_file("../temp/semantic-output.txt");
         if (!out_file.is_open()) {
             std::cerr << "Warning: Could not open 'temp/semantic-output.txt' for AI explanation\n";
@@ -136,16 +186,10 @@ int main(int argc, char* argv[]) {
     }
     if (intermediate_mode) {
         std::cout << "Generating intermediate code for " << source_file << "...\n";
-        runTACGeneration(ast_file.c_str());
+        runTACGeneration(*frontend.parse_result);
         stage = "intermediate";
         // Read input and output for help
-        std::ifstream in_file(ast_file);
-        if (!in_file.is_open()) {
-            std::cerr << "Warning: Could not open 'temp/parser-output.ast' for AI explanation\n";
-        }
-        std::stringstream in_buf;
-        in_buf << in_file.rdbuf();
-        input_data = in_buf.str();
+        input_data = formatParseTree(frontend);
         std::ifstream out_file("../temp/tac-output.txt");
         if (!out_file.is_open()) {
             std::cerr << "Warning: Could not open 'temp/tac-output.txt' for AI explanation\n";
@@ -156,16 +200,10 @@ int main(int argc, char* argv[]) {
     }
     if (target_mode) {
         std::cout << "Generating target code for " << source_file << "...\n";
-        runTargetCodeGeneration(ast_file.c_str());
+        runTargetCodeGeneration(*frontend.parse_result);
         stage = "target";
         // Read input and output for help
-        std::ifstream in_file(ast_file);
-        if (!in_file.is_open()) {
-            std::cerr << "Warning: Could not open 'temp/parser-output.ast' for AI explanation\n";
-        }
-        std::stringstream in_buf;
-        in_buf << in_file.rdbuf();
-        input_data = in_buf.str();
+        input_data = formatParseTree(frontend);
         std::ifstream out_file("../temp/target-output.txt");
         if (!out_file.is_open()) {
             std::cerr << "Warning: Could not open 'temp/target-output.txt' for AI explanation\n";
@@ -175,6 +213,15 @@ int main(int argc, char* argv[]) {
         output_data = out_buf.str();
     }
 
+    if (show_stats) {
+        std::cout << "\n";
+        frontend.strings.printStats(std::cout);
+        std::cout << "\n";
+        frontend.parse_arena.printStats(std::cout);
+        std::cout << "\n";
+        HeaderCache::shared().printStats(std::cout);
+    }
+
     if (help_mode) {
         std::string explanation = generate_ai_help(stage, source_file, input_data, output_data);
         std::cout << "===== AI EXPLANATION =====\n";
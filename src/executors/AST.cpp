@@ -1,29 +1,141 @@
 #include "../include/AST.h"
-#include <unordered_map>
-
-std::unordered_map<std::string, NodeType> nodeTypeMap = {
-    {"Program", NodeType::Program},
-    {"Preprocessor", NodeType::Preprocessor},
-    {"Struct", NodeType::Struct},
-    {"Function", NodeType::Function},
-    {"Declarations", NodeType::Declarations},
-    {"LocalDeclaration", NodeType::LocalDeclaration},
-    {"VarDecl", NodeType::VarDecl},
-    {"Assignment", NodeType::Assignment},
-    {"While", NodeType::While},
-    {"Call", NodeType::Call},
-    {"IfElse", NodeType::IfElse},
-    {"Return", NodeType::Return},
-    {"Identifier", NodeType::Identifier},
-    {"Number", NodeType::Number},
-    {"String", NodeType::String},
-    {"Address", NodeType::Address},
-    {"Modulo", NodeType::Modulo},
-    {"Equal", NodeType::Equal},
-    {"Add", NodeType::Add},
-    {"Less", NodeType::Less},
-    {"Increment", NodeType::Increment}
-};
-
-ASTNode::ASTNode(NodeType t, std::string val, std::string th, std::string cs, int l)
-    : type(t), value(val), typeHint(th), callString(cs), line(l) {}
\ No newline at end of file
+#include <algorithm>
+
+namespace {
+
+// Node types whose meaning is fixed by their own text and their operands: an expression made of
+// these alone can be shared
+bool isPureExpression(NodeType type) {
+    switch (type) {
+        case NodeType::Identifier:
+        case NodeType::Number:
+        case NodeType::String:
+        case NodeType::Address:
+        case NodeType::Modulo:
+        case NodeType::Equal:
+        case NodeType::Add:
+        case NodeType::Subtract:
+        case NodeType::Multiply:
+        case NodeType::Divide:
+        case NodeType::Less:
+        case NodeType::LessEqual:
+        case NodeType::Greater:
+        case NodeType::GreaterEqual:
+        case NodeType::NotEqual:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Node types after which a name may stand for something else
+bool changesNames(NodeType type) {
+    switch (type) {
+        case NodeType::Preprocessor:
+        case NodeType::Struct:
+        case NodeType::Function:
+        case NodeType::Declarations:
+        case NodeType::LocalDeclaration:
+        case NodeType::VarDecl:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// FNV-1a over 64-bit words
+constexpr uint64_t kHashBasis = 14695981039346656037ull;
+constexpr uint64_t kHashPrime = 1099511628211ull;
+
+uint64_t mix(uint64_t hash, uint64_t word) {
+    return (hash ^ word) * kHashPrime;
+}
+
+}
+
+NodeId AST::Builder::add(size_t depth, const ASTNode& node) {
+    if (!sharing) {
+        // Nothing to do as nodes close
+        open.resize(std::min(open.size(), depth));
+    }
+    while (open.size() > depth) {
+        close();
+    }
+    open.resize(depth);
+    NodeId id = static_cast<NodeId>(ast.nodes.size());
+    ast.nodes.push_back(node);
+    if (sharing) {
+        canonical.push_back(kNoNode);
+        ast.lineShifts.push_back(0);
+        bool condition = !open.empty() && ast.nodes[open.back().node].type == NodeType::IfElse &&
+                         ast.nodes[open.back().node].childCount == 2;
+        if (changesNames(node.type) || condition) {
+            seen.clear();
+        }
+    }
+    if (open.empty()) {
+        ast.rootId = id;
+    } else {
+        Open& parent = open.back();
+        if (parent.lastChild == kNoNode) {
+            ast.nodes[parent.node].firstChild = id;
+        } else {
+            ast.nodes[parent.lastChild].nextSibling = id;
+        }
+        ast.nodes[parent.node].childCount++;
+        parent.lastChild = id;
+    }
+    open.push_back(Open{id, kNoNode});
+    return id;
+}
+
+// Only called when sharing. The node being closed is the last one open, so every node after it in
+// the array is in its subtree, and all of those are closed already
+void AST::Builder::close() {
+    NodeId id = open.back().node;
+    open.pop_back();
+    ASTNode& node = ast.nodes[id];
+    if (node.type == NodeType::IfElse) {
+        // Its condition was the last thing built; nothing after it shares with it
+        seen.clear();
+        return;
+    }
+    if (!isPureExpression(node.type)) {
+        return;
+    }
+    uint64_t hash = mix(mix(mix(kHashBasis, static_cast<uint64_t>(node.type)), node.value.id()), node.typeHint.id());
+    for (NodeId child = node.firstChild; child != kNoNode; child = ast.nodes[child].nextSibling) {
+        if (canonical[child] == kNoNode) {
+            return;
+        }
+        hash = mix(hash, canonical[child]);
+    }
+    canonical[id] = id;
+    auto [entry, added] = seen.try_emplace(hash, id);
+    if (added || !sameExpression(id, entry->second)) {
+        return;
+    }
+    NodeId first = entry->second;
+    canonical[id] = first;
+    // Its children were all shared in turn, so none of them is the first of its kind; the
+    // first one's children stand in for them, shifted down to this one's lines
+    node.firstChild = ast.nodes[first].firstChild;
+    ast.lineShifts[id] = node.line - ast.nodes[first].line;
+    ast.nodes.resize(id + 1);
+    canonical.resize(id + 1);
+    ast.lineShifts.resize(id + 1);
+}
+
+bool AST::Builder::sameExpression(NodeId a, NodeId b) const {
+    const ASTNode& x = ast.nodes[a];
+    const ASTNode& y = ast.nodes[b];
+    if (x.type != y.type || x.value != y.value || x.typeHint != y.typeHint || x.childCount != y.childCount) {
+        return false;
+    }
+    for (NodeId i = x.firstChild, j = y.firstChild; i != kNoNode; i = ast.nodes[i].nextSibling, j = ast.nodes[j].nextSibling) {
+        if (canonical[i] != canonical[j]) {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
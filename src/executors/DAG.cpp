@@ -1,4 +1,4 @@
 #include "DAG.h"
 
-DAGNode::DAGNode(const std::string& o, const std::string& v, int i)
-    : op(o), value(v), result(""), id(i) {}
\ No newline at end of file
+DAGNode::DAGNode(Name o, Name v, int i)
+    : op(o), value(v), id(i) {}
\ No newline at end of file
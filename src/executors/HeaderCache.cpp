@@ -0,0 +1,311 @@
+#include "../include/HeaderCache.h"
+#include "../include/lexer_utils.hpp"
+#include <iomanip>
+#include <iostream>
+
+extern bool lexSourceFile(FrontendContext& ctx, const char* filename);
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Deeper than any sane include chain; stops a header that includes itself without a guard
+constexpr int kMaxIncludeDepth = 200;
+constexpr uint32_t kUnmapped = UINT32_MAX;
+
+constexpr uint32_t kIfdefId = reserved_lexeme_id("#ifdef");
+constexpr uint32_t kIfndefId = reserved_lexeme_id("#ifndef");
+constexpr uint32_t kElseId = reserved_lexeme_id("#else");
+constexpr uint32_t kEndifId = reserved_lexeme_id("#endif");
+
+std::string resolveInclude(const FrontendContext& ctx, const std::string& name, const std::string& from) {
+    std::error_code error;
+    fs::path candidate = fs::path(from).parent_path() / name;
+    if (fs::is_regular_file(candidate, error)) {
+        return fs::canonical(candidate, error).string();
+    }
+    for (const std::string& dir : ctx.include_dirs) {
+        candidate = fs::path(dir) / name;
+        if (fs::is_regular_file(candidate, error)) {
+            return fs::canonical(candidate, error).string();
+        }
+    }
+    return std::string();
+}
+
+// The guard macro when the first directive is #ifndef X, the next defines X, and the #endif that
+// closes it (with no #else) is the last token
+std::string detectGuard(const HeaderEntry& entry) {
+    const std::vector<Tokens>& tokens = entry.tokens;
+    if (tokens.size() < 4 || tokens[0].lexeme != kIfndefId || tokens[1].kind != TokenKind::Identifier
+        || (tokens[2].flags & TokenFlagDefine) == 0 || tokens.back().lexeme != kEndifId) {
+        return std::string();
+    }
+    std::string_view guard = entry.strings.view(tokens[1].lexeme);
+    if (split_define(entry.strings.view(tokens[2].lexeme)).first != guard) {
+        return std::string();
+    }
+    int depth = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        uint32_t id = tokens[i].lexeme;
+        if (id == kIfdefId || id == kIfndefId) {
+            depth++;
+        } else if (id == kElseId && depth == 1) {
+            return std::string();
+        } else if (id == kEndifId && --depth == 0 && i + 1 != tokens.size()) {
+            return std::string();
+        }
+    }
+    for (const UnknownTokens& token : entry.unknown_tokens) {
+        if (token.offset > tokens.back().offset) {
+            return std::string();
+        }
+    }
+    return std::string(guard);
+}
+
+std::shared_ptr<HeaderEntry> lexHeader(const std::string& path) {
+    FrontendContext header;
+    header.expand_macros = false;
+    header.expand_includes = false;
+    header.borrow_lexemes = false; // The entry outlives the mapping
+    if (!lexSourceFile(header, path.c_str())) {
+        return nullptr;
+    }
+    auto entry = std::make_shared<HeaderEntry>();
+    entry->path = path;
+    header.position(0); // Builds the line index while the text is still in memory
+    entry->lines = std::move(header.lines);
+    entry->strings = std::move(header.strings);
+    entry->tokens = std::move(header.tokens);
+    entry->unknown_tokens = std::move(header.unknown_tokens);
+    entry->guard = detectGuard(*entry);
+    return entry;
+}
+
+// Emits entry's tokens as tokens of file. The header was lexed with its conditionals as written;
+// they are evaluated here, as the scanner evaluates them, against the macros defined at this point,
+// and the tokens of inactive branches are dropped.
+void spliceHeader(FrontendContext& ctx, const HeaderEntry& entry, uint16_t file, int depth) {
+    // Spellings are borrowed from the entry, which ctx.include_sources keeps alive
+    std::vector<uint32_t> remap(entry.strings.size(), kUnmapped);
+    auto lexeme = [&](uint32_t id) {
+        if (id < kReservedLexemeCount || id == StringPool::kEmptyId) {
+            return id;
+        }
+        if (remap[id] == kUnmapped) {
+            remap[id] = ctx.strings.intern_borrowed(entry.strings.view(id));
+        }
+        return remap[id];
+    };
+
+    std::vector<Conditional> open;
+    uint32_t skipDepth = 0; // Like ctx.skip_depth; the region is inactive while open.back() is not taken
+    bool skipping = false;
+    auto conditional = [&](const char* text, uint32_t offset) {
+        ctx.emit_token(Tokens{ctx.strings.intern(text), offset, TokenKind::Preprocessor, TokenFlagConditional, file});
+    };
+
+    size_t unknown = 0;
+    auto emitUnknownBefore = [&](uint32_t offset) {
+        for (; unknown < entry.unknown_tokens.size() && entry.unknown_tokens[unknown].offset < offset; ++unknown) {
+            const UnknownTokens& token = entry.unknown_tokens[unknown];
+            if (!skipping) {
+                ctx.emit_unknown_token(UnknownTokens{lexeme(token.lexeme), token.offset, file});
+            }
+        }
+    };
+
+    for (size_t i = 0; i < entry.tokens.size(); ++i) {
+        const Tokens& token = entry.tokens[i];
+        std::string_view text = entry.strings.view(token.lexeme);
+        emitUnknownBefore(token.offset);
+
+        if ((token.lexeme == kIfdefId || token.lexeme == kIfndefId) && skipping) {
+            skipDepth++;
+            continue;
+        }
+        if ((token.lexeme == kIfdefId || token.lexeme == kIfndefId) && i + 1 < entry.tokens.size()
+            && entry.tokens[i + 1].kind == TokenKind::Identifier) {
+            ++i; // The name
+            std::string_view name = entry.strings.view(entry.tokens[i].lexeme);
+            std::string directive = std::string(text) + " " + std::string(name);
+            conditional(directive.c_str(), token.offset);
+            skipping = !open_conditional(ctx, open, name, token.lexeme == kIfdefId, token.offset);
+            skipDepth = 0;
+            continue;
+        }
+        if (token.lexeme == kElseId || token.lexeme == kEndifId) {
+            if (skipping && skipDepth > 0) {
+                skipDepth -= token.lexeme == kEndifId;
+                continue;
+            }
+            if (skipping && token.lexeme == kElseId && open.back().else_seen) {
+                continue;
+            }
+            if (open.empty() || (token.lexeme == kElseId && open.back().else_seen)) {
+                std::cerr << "Error: Unexpected " << text << " in " << entry.path << " at line "
+                          << entry.lines.position(token.offset).line << "\n";
+                continue;
+            }
+            conditional(token.lexeme == kElseId ? "#else" : "#endif", token.offset);
+            if (token.lexeme == kEndifId) {
+                open.pop_back();
+                skipping = false;
+            } else {
+                open.back().else_seen = true;
+                skipping = open.back().taken;
+                open.back().taken = true;
+            }
+            continue;
+        }
+        if (skipping) {
+            continue;
+        }
+
+        Tokens spliced{lexeme(token.lexeme), token.offset, token.kind, token.flags, file};
+        if (token.kind == TokenKind::Identifier) {
+            const std::string* expanded = find_macro(ctx, text);
+            if (expanded != nullptr && *expanded != text) {
+                if (expanded->empty()) {
+                    continue;
+                }
+                spliced.lexeme = ctx.strings.intern(*expanded);
+                spliced.kind = TokenKind::MacroExpansion;
+            }
+        }
+        ctx.emit_token(spliced);
+
+        if (token.flags & TokenFlagDefine) {
+            auto [name, value] = split_define(text);
+            define_macro(ctx, std::string(name), std::string(value));
+        } else if (token.flags & TokenFlagInclude) {
+            std::string_view target = text.substr(9); // After "#include "
+            target = target.substr(1, target.size() - 2);
+            if (token.flags & TokenFlagSystemInclude) {
+                ctx.included_files.emplace_back(target);
+            } else {
+                ctx.included_files.push_back("\"" + std::string(target) + "\"");
+                expandInclude(ctx, std::string(target), entry.path, depth + 1);
+            }
+        }
+    }
+    emitUnknownBefore(UINT32_MAX);
+    if (!open.empty()) {
+        std::cerr << "Error: Missing #endif in " << entry.path << " for the conditional at line "
+                  << entry.lines.position(open.back().offset).line << "\n";
+    }
+}
+
+}
+
+HeaderCache& HeaderCache::shared() {
+    static HeaderCache cache;
+    return cache;
+}
+
+std::shared_ptr<const HeaderEntry> HeaderCache::get(const std::string& path) {
+    std::error_code error;
+    fs::file_time_type modified = fs::last_write_time(path, error);
+    uintmax_t size = error ? 0 : fs::file_size(path, error);
+    if (error) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it != entries.end() && it->second->modified == modified && it->second->size == size) {
+            counters.hits++;
+            return it->second;
+        }
+    }
+
+    // Lexed outside the lock; two threads missing on the same header at once both lex it, and
+    // the later result replaces the earlier one
+    std::shared_ptr<HeaderEntry> entry = lexHeader(path);
+    if (!entry) {
+        return nullptr;
+    }
+    entry->modified = modified;
+    entry->size = size;
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.misses++;
+    entries[path] = entry;
+    return entry;
+}
+
+void HeaderCache::noteGuardSkip() {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.guardSkips++;
+}
+
+HeaderCacheStats HeaderCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void HeaderCache::printStats(std::ostream& os) const {
+    HeaderCacheStats current = stats();
+    size_t cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cached = entries.size();
+    }
+    os << "Header cache statistics\n";
+    os << std::string(40, '-') << "\n";
+    os << std::left << std::setw(24) << "Headers cached" << cached << "\n";
+    os << std::left << std::setw(24) << "Headers lexed" << current.misses << "\n";
+    os << std::left << std::setw(24) << "Cache hits" << current.hits << "\n";
+    os << std::left << std::setw(24) << "Guard skips" << current.guardSkips << "\n";
+    os << std::string(40, '-') << "\n";
+}
+
+void HeaderCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    counters = HeaderCacheStats();
+}
+
+void expandInclude(FrontendContext& ctx, const std::string& name, const std::string& from, int depth) {
+    if (depth >= kMaxIncludeDepth) {
+        std::cerr << "Error: #include nested too deeply at \"" << name << "\" in " << from << "\n";
+        return;
+    }
+    std::string path = resolveInclude(ctx, name, from);
+    if (path.empty()) {
+        std::cerr << "Error: Cannot find include file \"" << name << "\" (included from " << from << ")\n";
+        return;
+    }
+
+    // A guarded header seen before is skipped on the guard alone: no stat, no cache lookup
+    auto guard = ctx.include_guards.find(path);
+    if (guard != ctx.include_guards.end() && find_macro(ctx, guard->second) != nullptr) {
+        HeaderCache::shared().noteGuardSkip();
+        return;
+    }
+    std::shared_ptr<const HeaderEntry> entry = HeaderCache::shared().get(path);
+    if (!entry) {
+        std::cerr << "Error: Could not read include file " << path << "\n";
+        return;
+    }
+    if (!entry->guard.empty()) {
+        ctx.include_guards[path] = entry->guard;
+        if (find_macro(ctx, entry->guard) != nullptr) {
+            HeaderCache::shared().noteGuardSkip();
+            return;
+        }
+    }
+
+    size_t slot = 0;
+    while (slot < ctx.include_sources.size() && ctx.include_sources[slot] != entry) {
+        slot++;
+    }
+    if (slot == ctx.include_sources.size()) {
+        if (slot == UINT16_MAX) {
+            std::cerr << "Error: Too many included files at " << path << "\n";
+            return;
+        }
+        ctx.include_sources.push_back(entry);
+    }
+    spliceHeader(ctx, *entry, static_cast<uint16_t>(slot + 1), depth);
+}
@@ -0,0 +1,210 @@
+#include "../include/IncrementalLexer.h"
+#include "../include/lexer_utils.hpp"
+#include "../include/lexer.h"
+#include <algorithm>
+
+extern bool lexSourceFile(FrontendContext& ctx, const char* filename);
+
+namespace {
+
+// How far past its end a match can look before the scanner settles on it ("1.5e+" is one byte
+// short of an exponent); comments and literals left open look further and are handled apart
+constexpr uint32_t kLookahead = 4;
+
+// Directive tokens are scanned in the DEFINITION/INCLUDE states or change the conditional stack,
+// so a scan cannot restart on them
+bool restartable(const Tokens& token) {
+    return (token.flags & (TokenFlagDefine | TokenFlagInclude | TokenFlagConditional)) == 0;
+}
+
+bool sameDirectives(const Tokens* a, const Tokens* aEnd, const Tokens* b, const Tokens* bEnd) {
+    for (;; ++a, ++b) {
+        while (a != aEnd && restartable(*a)) ++a;
+        while (b != bEnd && restartable(*b)) ++b;
+        if (a == aEnd || b == bEnd) {
+            return a == aEnd && b == bEnd;
+        }
+        if (a->flags != b->flags || a->lexeme != b->lexeme) {
+            return false;
+        }
+    }
+}
+
+// Macros defined by the directives in [begin, end), in order
+std::unordered_map<std::string, std::string> macrosBefore(const FrontendContext& ctx, const Tokens* begin, const Tokens* end) {
+    std::unordered_map<std::string, std::string> macros;
+    for (const Tokens* token = begin; token != end; ++token) {
+        if (token->flags & TokenFlagDefine) {
+            auto [name, value] = split_define(ctx.strings.view(token->lexeme));
+            macros[std::string(name)] = std::string(value);
+        }
+    }
+    return macros;
+}
+
+
+}
+
+IncrementalLexer::IncrementalLexer(FrontendContext& context) : ctx(context) {}
+
+bool IncrementalLexer::open(const char* filename) {
+    // The text is edited in place, so pooled spellings must not be views into it
+    ctx.map_source = true;
+    ctx.borrow_lexemes = false;
+    ctx.expand_includes = false;
+    ctx.macros.clear();
+    ctx.included_files.clear();
+    if (!lexSourceFile(ctx, filename) || !ctx.source.isOpen()) {
+        return false;
+    }
+    openConstruct = ctx.scan_hazard;
+    stats = IncrementalLexStats();
+    stats.full = true;
+    stats.relexEnd = static_cast<uint32_t>(ctx.source.size());
+    stats.tokensInserted = ctx.tokens.size();
+    return true;
+}
+
+void IncrementalLexer::relexAll() {
+    stats = IncrementalLexStats();
+    stats.full = true;
+    stats.tokensReplaced = ctx.tokens.size();
+    ctx.tokens.clear();
+    ctx.unknown_tokens.clear();
+    ctx.strings.clear();
+    seed_reserved_lexemes(ctx.strings);
+    ctx.macros.clear();
+    ctx.included_files.clear();
+    ctx.conditions.clear();
+    ctx.scan_offset = 0;
+    ctx.scan_hazard = false;
+
+    yyscan_t scanner;
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Error: Could not initialise the scanner\n";
+        return;
+    }
+    ctx.source_in_memory = true;
+    yy_scan_buffer(ctx.source.data(), ctx.source.paddedSize(), scanner);
+    while (yylex(scanner) != ScanEnd) {}
+    yylex_destroy(scanner);
+    ctx.source_in_memory = false;
+
+    openConstruct = ctx.scan_hazard;
+    stats.relexEnd = static_cast<uint32_t>(ctx.source.size());
+    stats.tokensInserted = ctx.tokens.size();
+}
+
+bool IncrementalLexer::apply(const SourceEdit& edit) {
+    size_t size = ctx.source.size();
+    if (!ctx.source.isOpen() || edit.offset > size || edit.removed > size - edit.offset
+        || size - edit.removed + edit.inserted.size() >= UINT32_MAX) {
+        return false;
+    }
+    ctx.source.replace(edit.offset, edit.removed, edit.inserted);
+    ctx.lines.clear();
+    if (openConstruct || !ctx.use_scan_kernels) {
+        relexAll();
+        return true;
+    }
+    int64_t delta = static_cast<int64_t>(edit.inserted.size()) - edit.removed;
+    uint32_t editEnd = edit.offset + edit.removed; // In old offsets
+
+    // Restart on the last token that starts kLookahead bytes or more before the edit
+    std::vector<Tokens> old;
+    old.swap(ctx.tokens);
+    auto startsBefore = [](const Tokens& token, uint32_t offset) { return token.offset < offset; };
+    size_t first = 0;
+    uint32_t from = 0;
+    if (edit.offset >= kLookahead) {
+        size_t candidates = std::upper_bound(old.begin(), old.end(), edit.offset - kLookahead,
+                                             [](uint32_t offset, const Tokens& token) { return offset < token.offset; }) - old.begin();
+        while (candidates > 0 && !restartable(old[candidates - 1])) --candidates;
+        if (candidates > 0) {
+            first = candidates - 1;
+            from = old[first].offset;
+        }
+    }
+
+    // Old tokens past the edit are where the scan may fall back in step
+    size_t next = std::lower_bound(old.begin(), old.end(), editEnd, startsBefore) - old.begin();
+
+    std::vector<UnknownTokens> oldUnknown;
+    oldUnknown.swap(ctx.unknown_tokens);
+    std::unordered_map<std::string, std::string> finalMacros;
+    finalMacros.swap(ctx.macros);
+    if (!finalMacros.empty()) {
+        ctx.macros = macrosBefore(ctx, old.data(), old.data() + first);
+    }
+    std::vector<std::string> includes;
+    includes.swap(ctx.included_files);
+    ctx.conditions = open_conditionals_before(old.data(), old.data() + first);
+
+    yyscan_t scanner;
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Error: Could not initialise the scanner\n";
+        return false;
+    }
+    ctx.source_in_memory = true;
+    ctx.scan_offset = from;
+    ctx.scan_hazard = false;
+    yy_scan_buffer(ctx.source.data() + from, ctx.source.paddedSize() - from, scanner);
+    bool inStep = false;
+    while (!inStep) {
+        ctx.scan_limit = next < old.size() ? static_cast<uint32_t>(old[next].offset + delta) : UINT32_MAX;
+        if (yylex(scanner) != ScanLimitReached) {
+            next = old.size();
+            break;
+        }
+        if (ctx.scan_offset == ctx.scan_limit && restartable(old[next])) {
+            inStep = true;
+        } else {
+            // The scan overran that token: look further on
+            int64_t reached = static_cast<int64_t>(ctx.scan_offset) - delta;
+            next = std::lower_bound(old.begin() + next + 1, old.end(), static_cast<uint32_t>(reached), startsBefore) - old.begin();
+        }
+    }
+    ctx.scan_limit = UINT32_MAX;
+    uint32_t relexEnd = ctx.scan_offset;
+    yylex_destroy(scanner);
+    ctx.source_in_memory = false;
+
+    std::vector<Tokens> fresh;
+    fresh.swap(ctx.tokens);
+    std::vector<UnknownTokens> freshUnknown;
+    freshUnknown.swap(ctx.unknown_tokens);
+    ctx.tokens.swap(old);
+    ctx.unknown_tokens.swap(oldUnknown);
+    ctx.macros.swap(finalMacros);
+    ctx.included_files.swap(includes);
+
+    // A changed directive alters the macro table or the include list past the edit as well
+    if (!sameDirectives(ctx.tokens.data() + first, ctx.tokens.data() + next, fresh.data(), fresh.data() + fresh.size())) {
+        relexAll();
+        return true;
+    }
+    openConstruct = ctx.scan_hazard;
+
+    // Splice: shift the untouched tail, then swap the re-lexed range in
+    uint32_t oldEnd = next < ctx.tokens.size() ? ctx.tokens[next].offset : UINT32_MAX;
+    for (size_t i = next; i < ctx.tokens.size(); ++i) {
+        ctx.tokens[i].offset = static_cast<uint32_t>(ctx.tokens[i].offset + delta);
+    }
+    ctx.tokens.erase(ctx.tokens.begin() + first, ctx.tokens.begin() + next);
+    ctx.tokens.insert(ctx.tokens.begin() + first, fresh.begin(), fresh.end());
+
+    auto unknownBefore = [](const UnknownTokens& token, uint32_t offset) { return token.offset < offset; };
+    auto unknownFirst = std::lower_bound(ctx.unknown_tokens.begin(), ctx.unknown_tokens.end(), from, unknownBefore);
+    auto unknownEnd = std::lower_bound(unknownFirst, ctx.unknown_tokens.end(), oldEnd, unknownBefore);
+    for (auto it = unknownEnd; it != ctx.unknown_tokens.end(); ++it) {
+        it->offset = static_cast<uint32_t>(it->offset + delta);
+    }
+    ctx.unknown_tokens.insert(ctx.unknown_tokens.erase(unknownFirst, unknownEnd), freshUnknown.begin(), freshUnknown.end());
+
+    stats = IncrementalLexStats();
+    stats.relexBegin = from;
+    stats.relexEnd = relexEnd;
+    stats.tokensReplaced = next - first;
+    stats.tokensInserted = fresh.size();
+    return true;
+}
@@ -0,0 +1,61 @@
+#include "../include/LineIndex.h"
+#include "../include/ScanKernels.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+void LineIndex::clear() {
+    starts.clear();
+    built = false;
+}
+
+void LineIndex::addLineStarts(const char* begin, const char* end, uint32_t base) {
+    const ScanKernels& kernels = scanKernels();
+    for (const char* p = kernels.findByte(begin, end, '\n'); p != end; p = kernels.findByte(p, end, '\n')) {
+        ++p;
+        starts.push_back(base + static_cast<uint32_t>(p - begin));
+    }
+}
+
+void LineIndex::build(const char* begin, const char* end) {
+    clear();
+    starts.push_back(0);
+    addLineStarts(begin, end, 0);
+    built = true;
+}
+
+bool LineIndex::buildFromFile(const std::string& path) {
+    clear();
+    starts.push_back(0);
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        // Every offset then resolves to line 1; the caller has already reported the file
+        built = true;
+        return false;
+    }
+    std::vector<char> block(64 * 1024);
+    uint32_t base = 0;
+    size_t got;
+    while ((got = std::fread(block.data(), 1, block.size(), file)) > 0) {
+        addLineStarts(block.data(), block.data() + got, base);
+        base += static_cast<uint32_t>(got);
+    }
+    std::fclose(file);
+    built = true;
+    return true;
+}
+
+void LineIndex::assign(std::vector<uint32_t> lineStarts) {
+    starts = std::move(lineStarts);
+    built = true;
+}
+
+SourcePosition LineIndex::position(uint32_t offset) const {
+    if (starts.empty()) {
+        return SourcePosition{1, offset + 1};
+    }
+    // Last line start at or before offset
+    auto it = std::upper_bound(starts.begin(), starts.end(), offset);
+    size_t line = static_cast<size_t>(it - starts.begin()); // starts[0] == 0, so line >= 1
+    return SourcePosition{static_cast<uint32_t>(line), offset - starts[line - 1] + 1};
+}
@@ -0,0 +1,104 @@
+#include "../include/MappedFile.h"
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : base(nullptr), length(0), mappedLength(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        ::close(fd);
+        return readIntoHeap(path);
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t reserved = (fileSize + 2 + pageSize - 1) / pageSize * pageSize;
+
+    // Reserve zeroed pages for contents plus padding, then map the file over the front of them.
+    // The tail of the last file page reads as zero, so the two NULs are there without writing them.
+    void* region = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        ::close(fd);
+        return readIntoHeap(path);
+    }
+    void* contents = mmap(region, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    ::close(fd);
+    if (contents == MAP_FAILED) {
+        munmap(region, reserved);
+        return readIntoHeap(path);
+    }
+    madvise(region, fileSize, MADV_SEQUENTIAL);
+
+    base = static_cast<char*>(region);
+    length = fileSize;
+    mappedLength = reserved;
+    return true;
+#else
+    return readIntoHeap(path);
+#endif
+}
+
+bool MappedFile::readIntoHeap(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    heap.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    length = heap.size();
+    heap.push_back('\0');
+    heap.push_back('\0');
+    base = heap.data();
+    return true;
+}
+
+void MappedFile::assign(std::string_view text) {
+    close();
+    heap.reserve(text.size() + 2);
+    heap.assign(text.begin(), text.end());
+    length = heap.size();
+    heap.push_back('\0');
+    heap.push_back('\0');
+    base = heap.data();
+}
+
+void MappedFile::replace(size_t offset, size_t count, std::string_view text) {
+    if (isMapped()) {
+        std::vector<char> contents(base, base + length + 2); // The zeroed page tail supplies the padding
+        close();
+        heap = std::move(contents);
+    }
+    heap.erase(heap.begin() + offset, heap.begin() + offset + count);
+    heap.insert(heap.begin() + offset, text.begin(), text.end());
+    length = heap.size() - 2;
+    base = heap.data();
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mappedLength != 0) {
+        munmap(base, mappedLength);
+    }
+#endif
+    heap.clear();
+    heap.shrink_to_fit();
+    base = nullptr;
+    length = 0;
+    mappedLength = 0;
+}
@@ -0,0 +1,182 @@
+#include "../include/ParallelLexer.h"
+#include "../include/lexer_utils.hpp"
+#include "../include/lexer.h"
+#include "../include/ScanKernels.h"
+#include "../include/trace.hpp"
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Below this a chunk is not worth a thread
+constexpr size_t kMinChunkBytes = 1 << 20;
+constexpr uint32_t kUnmapped = UINT32_MAX - 1;
+
+struct Chunk {
+    uint32_t begin;
+    uint32_t end;
+    FrontendContext ctx;
+
+    Chunk(uint32_t from, uint32_t to) : begin(from), end(to) {}
+};
+
+void lexChunk(Chunk& chunk, const FrontendContext& whole) {
+    FrontendContext& ctx = chunk.ctx;
+    ctx.speculative = true;
+    ctx.expand_macros = whole.expand_macros;
+    ctx.expand_includes = whole.expand_includes;
+    ctx.source.assign(whole.source.view().substr(chunk.begin, chunk.end - chunk.begin));
+    ctx.source_in_memory = true;
+    ctx.use_scan_kernels = true;
+    ctx.scan_offset = chunk.begin;
+
+    yyscan_t scanner;
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        ctx.scan_hazard = true;
+        return;
+    }
+    yy_scan_buffer(ctx.source.data(), ctx.source.paddedSize(), scanner);
+    while (yylex(scanner) != ScanEnd) {}
+    yylex_destroy(scanner);
+}
+
+// Identifiers that a macro defined before the chunk would have expanded
+bool usesEarlierMacros(const FrontendContext& ctx, const FrontendContext& part) {
+    if (ctx.macros.empty() || !ctx.expand_macros) {
+        return false;
+    }
+    for (const Tokens& token : part.tokens) {
+        if (token.kind == TokenKind::Identifier && find_macro(ctx, part.strings.view(token.lexeme)) != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Move a chunk's results into ctx, re-interning its spellings in ctx's pool. Text borrowed from
+// the chunk's copy is borrowed from the same bytes of the mapped file instead.
+void appendChunk(FrontendContext& ctx, Chunk& chunk) {
+    const FrontendContext& part = chunk.ctx;
+    const char* copy = part.source.data();
+    const char* original = ctx.source.data() + chunk.begin;
+    std::vector<uint32_t> remap(part.strings.size(), kUnmapped);
+    auto translate = [&](uint32_t id) {
+        if (id == StringPool::kEmptyId) {
+            return id;
+        }
+        uint32_t& mapped = remap[id];
+        if (mapped == kUnmapped) {
+            std::string_view text = part.strings.view(id);
+            if (ctx.borrow_lexemes && text.data() >= copy && text.data() < copy + part.source.size()) {
+                mapped = ctx.strings.intern_borrowed(std::string_view(original + (text.data() - copy), text.size()));
+            } else {
+                mapped = ctx.strings.intern(text);
+            }
+        }
+        return mapped;
+    };
+
+    for (Tokens token : part.tokens) {
+        token.lexeme = translate(token.lexeme);
+        ctx.tokens.push_back(token);
+    }
+    for (UnknownTokens token : part.unknown_tokens) {
+        token.lexeme = translate(token.lexeme);
+        ctx.unknown_tokens.push_back(token);
+    }
+    ctx.included_files.insert(ctx.included_files.end(), part.included_files.begin(), part.included_files.end());
+    for (const auto& [name, value] : part.macros) {
+        ctx.macros[name] = value;
+    }
+}
+
+// Lex serially into ctx from the start of chunk index until a match starts exactly on a later
+// chunk's boundary; returns that chunk's index, or chunks.size() at the end of the file
+size_t relexFrom(FrontendContext& ctx, const std::vector<std::unique_ptr<Chunk>>& chunks, size_t index) {
+    uint32_t from = chunks[index]->begin;
+    yyscan_t scanner;
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Error: Could not initialise the scanner\n";
+        return chunks.size();
+    }
+    yy_scan_buffer(ctx.source.data() + from, ctx.source.paddedSize() - from, scanner);
+    ctx.scan_offset = from;
+
+    size_t next = index + 1;
+    for (;;) {
+        ctx.scan_limit = next < chunks.size() ? chunks[next]->begin : UINT32_MAX;
+        if (yylex(scanner) != ScanLimitReached) {
+            next = chunks.size();
+            break;
+        }
+        if (ctx.scan_offset == ctx.scan_limit) {
+            break; // In step again: chunk next's speculative scan holds
+        }
+        ++next; // A match ran across the boundary, so chunk next started mid-match as well
+    }
+    ctx.scan_limit = UINT32_MAX;
+    yylex_destroy(scanner);
+    return next;
+}
+
+}
+
+bool lexSourceInParallel(FrontendContext& ctx) {
+    unsigned jobs = ctx.lex_jobs != 0 ? ctx.lex_jobs : std::thread::hardware_concurrency();
+    size_t size = ctx.source.size();
+    size_t count = std::min<size_t>(jobs, size / kMinChunkBytes);
+    // Chunks scan in the FAST state, and lexer traces would interleave across threads
+    if (count < 2 || !ctx.source_in_memory || !ctx.use_scan_kernels || size >= UINT32_MAX
+        || trace_enabled(TraceLevel::Info, TraceCategory::Lexer)) {
+        return false;
+    }
+
+    // Cut at line starts near equal shares of the file
+    const char* data = ctx.source.data();
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    uint32_t begin = 0;
+    for (size_t k = 1; k <= count && begin < size; ++k) {
+        uint32_t end = static_cast<uint32_t>(size);
+        if (k < count) {
+            const char* target = data + std::max<size_t>(size * k / count, begin);
+            const char* newline = scanKernels().findByte(target, data + size, '\n');
+            end = newline == data + size ? static_cast<uint32_t>(size) : static_cast<uint32_t>(newline - data + 1);
+        }
+        if (end > begin) {
+            chunks.push_back(std::make_unique<Chunk>(begin, end));
+            begin = end;
+        }
+    }
+    UC_TRACE(TraceLevel::Debug, TraceCategory::Lexer, "Lexing " << size << " bytes in " << chunks.size() << " chunks");
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (auto& chunk : chunks) {
+        workers.emplace_back(lexChunk, std::ref(*chunk), std::cref(ctx));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk->ctx.tokens.size();
+    }
+    ctx.tokens.reserve(total);
+
+    // Each step starts on a chunk boundary that the correct scan also starts a match on. Only a
+    // blank run can cross a boundary without leaving a hazard behind, and blanks yield no tokens.
+    size_t i = 0;
+    while (i < chunks.size()) {
+        Chunk& chunk = *chunks[i];
+        if (!chunk.ctx.scan_hazard && !usesEarlierMacros(ctx, chunk.ctx)) {
+            appendChunk(ctx, chunk);
+            chunks[i++].reset();
+        } else {
+            i = relexFrom(ctx, chunks, i);
+        }
+    }
+    return true;
+}
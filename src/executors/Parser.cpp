@@ -1,191 +1,338 @@
 #include "../include/Parser.h"
-#include <fstream>
-#include <sstream>
+#include "../include/MappedFile.h"
+#include "../include/parser_utils.hpp"
+#include "../include/trace.hpp"
 #include <stdexcept>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
-ParsedNode::ParsedNode(NodeType t, const std::string& val, const std::string& th, const std::string& cs, int l)
-    : type(t), value(val), typeHint(th), callString(cs), line(l) {}
+namespace {
 
-ParsedNode parseLine(const std::string& line, int lineNumber) {
-    std::string trimmed = line;
-    trimmed.erase(trimmed.begin(), std::find_if(trimmed.begin(), trimmed.end(), [](unsigned char c) { return !std::isspace(c); }));
-    trimmed.erase(std::find_if(trimmed.rbegin(), trimmed.rend(), [](unsigned char c) { return !std::isspace(c); }).base(), trimmed.end());
+// std::isspace in the C locale, without the call
+constexpr bool isBlank(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
 
-    if (trimmed.empty()) {
-        throw std::runtime_error("Empty line at line " + std::to_string(lineNumber));
+std::string_view trimLeft(std::string_view text) {
+    size_t start = 0;
+    while (start < text.size() && isBlank(text[start])) {
+        start++;
     }
+    return text.substr(start);
+}
 
-    // Skip artifact lines (e.g., EOF, terminal prompts)
-    if (trimmed == "EOF" || trimmed.find("@") != std::string::npos) {
-        throw std::runtime_error("Invalid line artifact: '" + trimmed + "' at line " + std::to_string(lineNumber));
+std::string_view trimRight(std::string_view text) {
+    size_t end = text.size();
+    while (end > 0 && isBlank(text[end - 1])) {
+        end--;
     }
+    return text.substr(0, end);
+}
 
-    std::string nodeTypeStr;
-    std::string rest;
-    size_t colonPos = trimmed.find(':');
-    if (colonPos == std::string::npos) {
-        // No colon: treat entire line as node type with empty value
-        nodeTypeStr = trimmed;
-        rest = "";
-        std::cout << "Debug: Parsed line " << lineNumber << ": No colon, Type=" << nodeTypeStr << ", Value=, TypeHint=" << std::endl;
-    } else {
-        // Colon present: split into node type and rest
-        nodeTypeStr = trimmed.substr(0, colonPos);
-        rest = trimmed.substr(colonPos + 1);
-        rest.erase(rest.begin(), std::find_if(rest.begin(), rest.end(), [](unsigned char c) { return !std::isspace(c); }));
-        std::cout << "Debug: Parsed line " << lineNumber << ": Colon found, Type=" << nodeTypeStr << ", Rest=" << rest << std::endl;
+// Drops trailing spaces only (not other blanks), as the text AST pads names with them
+std::string_view trimTrailingSpaces(std::string_view text) {
+    size_t last = text.find_last_not_of(' ');
+    return text.substr(0, last == std::string_view::npos ? 0 : last + 1);
+}
+
+std::string lineError(const char* what, std::string_view text, int lineNumber) {
+    std::string message(what);
+    message += text;
+    message += "' at line ";
+    message += std::to_string(lineNumber);
+    return message;
+}
+
+// Small direct-mapped memo in front of the string pool. An AST repeats a handful of spellings
+// (type names, variables, small numbers) on most of its lines, so most names are found here with
+// one hash and one compare, instead of a full pool lookup.
+class NameMemo {
+private:
+    struct Slot {
+        std::string_view text; // The pool's copy
+        Name name;
+    };
+    static constexpr size_t kSlots = 1024;
+    std::vector<Slot> slots = std::vector<Slot>(kSlots);
+
+    static uint64_t load(const char* bytes, size_t count) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes, count);
+        return word;
     }
 
-    if (nodeTypeStr.empty()) {
-        throw std::runtime_error("Empty node type in line: '" + trimmed + "' at line " + std::to_string(lineNumber));
+    // Hashes the first and last eight bytes and the length, so the cost does not grow with the
+    // text; spellings alike at both ends only share a slot, the compare still tells them apart
+    static size_t slotOf(std::string_view text) {
+        size_t size = text.size();
+        uint64_t head = load(text.data(), std::min<size_t>(size, 8));
+        uint64_t tail = size > 8 ? load(text.data() + size - 8, 8) : 0;
+        uint64_t hash = (head * 0x9E3779B97F4A7C15ull) ^ ((tail + size) * 0xC2B2AE3D27D4EB4Full);
+        return static_cast<size_t>(hash >> 40) & (kSlots - 1);
     }
 
-    auto it = nodeTypeMap.find(nodeTypeStr);
-    if (it == nodeTypeMap.end()) {
-        throw std::runtime_error("Unknown node type: '" + nodeTypeStr + "' at line " + std::to_string(lineNumber));
+public:
+    Name get(std::string_view text) {
+        if (text.empty()) {
+            return Name();
+        }
+        Slot& slot = slots[slotOf(text)];
+        if (slot.text != text) {
+            slot.name = Name(text);
+            slot.text = slot.name.view();
+        }
+        return slot.name;
     }
+};
+
+ASTNode makeASTNode(const ParsedNode& parsed, NameMemo& names) {
+    ASTNode node;
+    node.type = parsed.type;
+    node.value = names.get(parsed.value);
+    node.typeHint = names.get(parsed.typeHint);
+    node.callString = names.get(parsed.callString);
+    node.line = parsed.line;
+    return node;
+}
 
-    NodeType nodeType = it->second;
-    std::string value = rest;
-    std::string typeHint;
-    std::string callString;
+}
+
+ParsedNode classifyNode(std::string_view nodeTypeStr, std::string_view rest, int lineNumber) {
+    NodeType nodeType;
+    if (!findNodeType(nodeTypeStr, nodeType)) {
+        throw std::runtime_error(lineError("Unknown node type: '", nodeTypeStr, lineNumber));
+    }
+
+    ParsedNode parsed{nodeType, rest, {}, {}, lineNumber};
 
     if (nodeType == NodeType::Function) {
         size_t parenPos = rest.find('(');
-        if (parenPos != std::string::npos) {
-            value = rest.substr(0, parenPos);
+        if (parenPos != std::string_view::npos) {
+            parsed.value = trimTrailingSpaces(rest.substr(0, parenPos));
             size_t endParenPos = rest.find(')', parenPos);
-            if (endParenPos != std::string::npos) {
-                typeHint = rest.substr(parenPos + 1, endParenPos - parenPos - 1);
+            if (endParenPos != std::string_view::npos) {
+                parsed.typeHint = rest.substr(parenPos + 1, endParenPos - parenPos - 1);
             }
-            value.erase(value.find_last_not_of(' ') + 1);
-        } else {
-            value = rest;
         }
     } else if (nodeType == NodeType::LocalDeclaration) {
         size_t spacePos = rest.find(' ');
-        if (spacePos != std::string::npos) {
-            typeHint = rest.substr(0, spacePos);
-            value = rest.substr(spacePos + 1);
-            if (value == "declarations") {
-                nodeType = NodeType::Declarations;
-                value = "";
-                typeHint = "";
+        if (spacePos != std::string_view::npos) {
+            parsed.typeHint = rest.substr(0, spacePos);
+            parsed.value = rest.substr(spacePos + 1);
+            if (parsed.value == "declarations") {
+                parsed.type = NodeType::Declarations;
+                parsed.value = {};
+                parsed.typeHint = {};
             }
         }
     } else if (nodeType == NodeType::VarDecl) {
         size_t spacePos = rest.find(' ');
-        if (spacePos != std::string::npos) {
-            typeHint = rest.substr(0, spacePos); // e.g., "int"
-            std::string declRest = rest.substr(spacePos + 1);
-            size_t equalPos = declRest.find('=');
-            if (equalPos != std::string::npos) {
-                value = declRest.substr(0, equalPos);
-                value.erase(value.find_last_not_of(' ') + 1);
-            } else {
-                value = declRest;
-                value.erase(value.find_last_not_of(' ') + 1);
-            }
+        if (spacePos != std::string_view::npos) {
+            parsed.typeHint = rest.substr(0, spacePos); // e.g., "int"
+            std::string_view declRest = rest.substr(spacePos + 1);
+            parsed.value = trimTrailingSpaces(declRest.substr(0, declRest.find('=')));
         }
     } else if (nodeType == NodeType::Assignment) {
         size_t equalPos = rest.find('=');
-        if (equalPos != std::string::npos) {
-            value = rest.substr(0, equalPos);
-            value.erase(value.find_last_not_of(' ') + 1);
-        } else {
-            value = rest;
+        if (equalPos != std::string_view::npos) {
+            parsed.value = trimTrailingSpaces(rest.substr(0, equalPos));
         }
     } else if (nodeType == NodeType::Call) {
         // Handle quoted function names (e.g., "printf(...)")
-        if (rest[0] == '"') {
+        if (!rest.empty() && rest[0] == '"') {
             size_t endQuotePos = rest.find('"', 1);
-            if (endQuotePos == std::string::npos) {
+            if (endQuotePos == std::string_view::npos) {
                 throw std::runtime_error("Unterminated quote in Call node at line " + std::to_string(lineNumber));
             }
-            std::string funcName = rest.substr(1, endQuotePos - 1);
-            size_t parenPos = funcName.find('(');
-            if (parenPos != std::string::npos) {
-                value = funcName.substr(0, parenPos); // Function name only
-            } else {
-                value = funcName;
-            }
-            callString = rest; // Full call string with quotes
+            std::string_view funcName = rest.substr(1, endQuotePos - 1);
+            parsed.value = funcName.substr(0, funcName.find('(')); // Function name only
         } else {
-            size_t parenPos = rest.find('(');
-            if (parenPos != std::string::npos) {
-                value = rest.substr(0, parenPos); // Function name only
-                callString = rest; // Full call string
-            } else {
-                value = rest;
-                callString = rest;
-            }
+            parsed.value = rest.substr(0, rest.find('(')); // Function name only
         }
+        parsed.callString = rest; // Full call string, quotes included
     } else if (nodeTypeStr == "Expression") {
         if (rest.size() >= 2 && rest.substr(rest.size() - 2) == "++") {
-            nodeType = NodeType::Increment;
-            value = rest.substr(0, rest.size() - 2);
-            typeHint = "";
+            parsed.type = NodeType::Increment;
+            parsed.value = rest.substr(0, rest.size() - 2);
         } else {
-            throw std::runtime_error("Invalid expression format: '" + rest + "' at line " + std::to_string(lineNumber));
+            throw std::runtime_error(lineError("Invalid expression format: '", rest, lineNumber));
         }
     }
 
-    std::cout << "Debug: Final parsed line " << lineNumber << ": Type=" << nodeTypeStr << ", Value=" << value << ", TypeHint=" << typeHint << std::endl;
+    UC_TRACE(TraceLevel::Debug, TraceCategory::AST, "Debug: Parsed line " << lineNumber << ": Type=" << nodeTypeStr << ", Value=" << parsed.value << ", TypeHint=" << parsed.typeHint);
 
-    return ParsedNode(nodeType, value, typeHint, callString, lineNumber);
+    return parsed;
 }
 
-std::shared_ptr<ASTNode> readASTFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+namespace {
+
+// line comes with its indent already stepped over
+ParsedNode parseLine(std::string_view line, int lineNumber) {
+    std::string_view trimmed = trimRight(trimLeft(line));
+
+    if (trimmed.empty()) {
+        throw std::runtime_error("Empty line at line " + std::to_string(lineNumber));
+    }
+
+    // Skip artifact lines (e.g., EOF, terminal prompts)
+    if (trimmed == "EOF" || trimmed.find('@') != std::string_view::npos) {
+        throw std::runtime_error(lineError("Invalid line artifact: '", trimmed, lineNumber));
+    }
+
+    // No colon: the entire line is the node type, with an empty value
+    std::string_view nodeTypeStr = trimmed;
+    std::string_view rest;
+    size_t colonPos = trimmed.find(':');
+    if (colonPos != std::string_view::npos) {
+        nodeTypeStr = trimmed.substr(0, colonPos);
+        rest = trimLeft(trimmed.substr(colonPos + 1));
+    }
+
+    if (nodeTypeStr.empty()) {
+        throw std::runtime_error(lineError("Empty node type in line: '", trimmed, lineNumber));
+    }
+    return classifyNode(nodeTypeStr, rest, lineNumber);
+}
+
+}
+
+AST readASTFromFile(const std::string& filename) {
+    // The dump is scanned in place: each line is a view into the mapping, and a node's text is
+    // interned straight from it
+    MappedFile file;
+    if (!file.open(filename)) {
         throw std::runtime_error("Could not open file: " + filename);
     }
 
-    std::vector<std::shared_ptr<ASTNode>> nodeStack;
-    std::vector<size_t> indentStack;
-    std::string line;
+    AST ast;
+    AST::Builder builder(ast);
+    std::vector<size_t> indentStack; // Indents of the open nodes, root first
+    NameMemo names;
+    std::string_view text = file.view();
     int lineNumber = 0;
 
-    while (std::getline(file, line)) {
+    for (size_t lineStart = 0; lineStart < text.size();) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
         lineNumber++;
-        try {
-            if (line.empty()) {
-                continue;
-            }
+        if (line.empty()) {
+            continue;
+        }
 
+        try {
             size_t indent = 0;
             while (indent < line.length() && line[indent] == ' ') {
                 indent++;
             }
 
-            auto parsed = parseLine(line, lineNumber);
-            auto node = std::make_shared<ASTNode>(parsed.type, parsed.value, parsed.typeHint, parsed.callString, parsed.line);
+            ASTNode node = makeASTNode(parseLine(line.substr(indent), lineNumber), names);
 
             while (!indentStack.empty() && indent <= indentStack.back()) {
                 indentStack.pop_back();
-                nodeStack.pop_back();
             }
 
-            if (nodeStack.empty()) {
-                nodeStack.push_back(node);
-            } else {
-                nodeStack.back()->children.push_back(node);
-                nodeStack.push_back(node);
-            }
+            builder.add(indentStack.size(), node);
             indentStack.push_back(indent);
         } catch (const std::exception& e) {
-            file.close();
             throw std::runtime_error("Parse error at line " + std::to_string(lineNumber) + ": " + e.what());
         }
     }
 
-    file.close();
-
-    if (nodeStack.empty()) {
+    if (ast.empty()) {
         throw std::runtime_error("No valid AST nodes parsed from file: " + filename);
     }
 
-    return nodeStack[0];
+    return ast;
+}
+
+namespace {
+
+// Visits the parse tree in dump order (walk_parse_tree), so line is the dump line of the node being
+// built, and fills each node from the parse node's own fields
+class ASTBuilder {
+private:
+    int line = 0;
+    NameMemo names;
+    std::string escaped;
+    AST ast;
+    AST::Builder builder;
+
+    ASTNode begin(std::string_view typeName) {
+        line++;
+        ASTNode node;
+        if (!findNodeType(typeName, node.type)) {
+            throw std::runtime_error("Parse error at line " + std::to_string(line) + ": " +
+                                     lineError("Unknown node type: '", typeName, line));
+        }
+        node.line = line;
+        return node;
+    }
+
+    // value as the AST keeps text: a string holding newlines is stored with \n escapes
+    Name stored(std::string_view value) {
+        value = trimRight(trimLeft(value));
+        if (value.find('\n') == std::string_view::npos) {
+            return names.get(value);
+        }
+        escaped.clear();
+        append_display_value(escaped, value);
+        return names.get(escaped);
+    }
+
+public:
+    explicit ASTBuilder(bool shareExpressions) : builder(ast, shareExpressions) {}
+
+    void visit(const ProgramNode&, int depth) {
+        builder.add(depth, begin("Program"));
+    }
+    void visit(const FunctionNode& func, int depth) {
+        ASTNode node = begin("Function");
+        node.value = names.get(func.name);
+        node.typeHint = names.get(func.return_type);
+        builder.add(depth, node);
+    }
+    void visit(const StatementNode& stmt, int depth) {
+        ASTNode node = begin(stmt.type);
+        switch (node.type) {
+            case NodeType::LocalDeclaration:
+                // Only its VarDecls carry anything
+                node.type = NodeType::Declarations;
+                break;
+            case NodeType::VarDecl:
+                node.value = names.get(stmt.name);
+                node.typeHint = names.get(stmt.type_hint);
+                break;
+            case NodeType::Assignment:
+                node.value = names.get(stmt.name);
+                break;
+            case NodeType::Call:
+                node.value = names.get(stmt.name);
+                node.callString = stored(stmt.value);
+                break;
+            default:
+                node.value = stored(stmt.value);
+                break;
+        }
+        builder.add(depth, node);
+    }
+    void visit(const ParseNode& expr, int depth) {
+        ASTNode node = begin(expr.type);
+        node.value = stored(expr.value);
+        builder.add(depth, node);
+    }
+
+    AST take() { return std::move(ast); }
+};
+
+}
+
+AST buildAST(const ProgramNode& program, bool shareExpressions) {
+    ASTBuilder builder(shareExpressions);
+    walk_parse_tree(program, builder);
+    return builder.take();
 }
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "../include/PreludeSnapshot.h"
+#include "../include/lexer_utils.hpp"
+#include "../include/trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kMagic[8] = {'U', 'C', 'T', 'P', 'C', 'H', '\0', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kUnmapped = UINT32_MAX - 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tokenBytes;      // sizeof(Tokens): token arrays are stored as they are in memory
+    uint32_t reservedLexemes; // Ids below this are reserved spellings, the same in every pool
+    uint32_t preludeBytes;
+    uint64_t preludeHash;     // FNV-1a of the prelude's bytes
+};
+
+uint64_t fnv1a(std::string_view bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string sourceDirectory(const FrontendContext& ctx) {
+    std::error_code error;
+    return fs::weakly_canonical(fs::path(ctx.source_path), error).parent_path().string();
+}
+
+class Writer {
+private:
+    std::string out;
+
+public:
+    template <typename T>
+    void put(const T& value) { out.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void putString(std::string_view text) {
+        put(static_cast<uint32_t>(text.size()));
+        out.append(text);
+    }
+    const std::string& bytes() const { return out; }
+};
+
+// Bounds-checked cursor over the mapped snapshot; a read past the end marks it failed
+class Reader {
+private:
+    const char* cursor;
+    const char* end;
+    bool failed = false;
+
+public:
+    Reader(const char* begin, const char* limit) : cursor(begin), end(limit) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (failed || static_cast<size_t>(end - cursor) < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+    std::string_view getString() {
+        uint32_t length = get<uint32_t>();
+        if (failed || static_cast<size_t>(end - cursor) < length) {
+            failed = true;
+            return std::string_view();
+        }
+        std::string_view text(cursor, length);
+        cursor += length;
+        return text;
+    }
+    bool ok() const { return !failed; }
+};
+
+// The prelude of a file lexed from scratch: its tokens are tokens[0, tokens), its text is the
+// file's bytes [0, bytes), and its headers are include_sources[0, headers)
+struct Prelude {
+    size_t tokens = 0;
+    uint32_t bytes = 0;
+    uint16_t headers = 0;
+};
+
+constexpr uint8_t kDirectiveFlags = TokenFlagDefine | TokenFlagInclude | TokenFlagConditional;
+
+// False when there is nothing to save, or the prelude holds an unknown token (the scan cannot
+// restart after it in the state it was in)
+bool findPrelude(const FrontendContext& ctx, Prelude& prelude) {
+    prelude.tokens = ctx.tokens.size();
+    prelude.bytes = static_cast<uint32_t>(ctx.source.size());
+    for (size_t i = 0; i < ctx.tokens.size(); ++i) {
+        const Tokens& token = ctx.tokens[i];
+        if (token.file == 0 && (token.flags & kDirectiveFlags) == 0) {
+            prelude.tokens = i;
+            prelude.bytes = token.offset;
+            break;
+        }
+    }
+    for (const UnknownTokens& token : ctx.unknown_tokens) {
+        if (token.file == 0 && token.offset < prelude.bytes) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < prelude.tokens; ++i) {
+        prelude.headers = std::max(prelude.headers, ctx.tokens[i].file);
+    }
+    return prelude.tokens > 0;
+}
+
+}
+
+bool savePreludeSnapshot(const FrontendContext& ctx) {
+    Prelude prelude;
+    if (!ctx.source.isOpen() || !findPrelude(ctx, prelude)) {
+        return false;
+    }
+
+    // Only the spellings the prelude uses, renumbered after the reserved ones
+    std::vector<uint32_t> remap(ctx.strings.size(), kUnmapped);
+    std::vector<std::string_view> spellings;
+    auto lexeme = [&](uint32_t id) {
+        if (id < kReservedLexemeCount || id == StringPool::kEmptyId) {
+            return id;
+        }
+        if (remap[id] == kUnmapped) {
+            remap[id] = kReservedLexemeCount + static_cast<uint32_t>(spellings.size());
+            spellings.push_back(ctx.strings.view(id));
+        }
+        return remap[id];
+    };
+    std::vector<Tokens> tokens(ctx.tokens.begin(), ctx.tokens.begin() + prelude.tokens);
+    std::vector<UnknownTokens> unknown;
+    size_t includes = 0;
+    std::unordered_map<std::string, std::string> macros;
+    for (Tokens& token : tokens) {
+        std::string_view text = ctx.strings.view(token.lexeme);
+        if (token.flags & TokenFlagDefine) {
+            auto [name, value] = split_define(text);
+            macros[std::string(name)] = std::string(value);
+        } else if (token.flags & TokenFlagInclude) {
+            includes++;
+        }
+        token.lexeme = lexeme(token.lexeme);
+    }
+    for (const UnknownTokens& token : ctx.unknown_tokens) {
+        if (token.file != 0 && token.file <= prelude.headers) {
+            unknown.push_back(UnknownTokens{lexeme(token.lexeme), token.offset, token.file});
+        }
+    }
+    std::vector<Conditional> conditions = open_conditionals_before(ctx.tokens.data(), ctx.tokens.data() + prelude.tokens);
+
+    Writer out;
+    SnapshotHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.tokenBytes = sizeof(Tokens);
+    header.reservedLexemes = kReservedLexemeCount;
+    header.preludeBytes = prelude.bytes;
+    header.preludeHash = fnv1a(ctx.source.view().substr(0, prelude.bytes));
+    out.put(header);
+    out.put(static_cast<uint32_t>(spellings.size()));
+    for (std::string_view spelling : spellings) {
+        out.putString(spelling);
+    }
+    out.putString(sourceDirectory(ctx));
+    out.put(static_cast<uint32_t>(ctx.include_dirs.size()));
+    for (const std::string& dir : ctx.include_dirs) {
+        out.putString(dir);
+    }
+    out.put(static_cast<uint32_t>(prelude.headers));
+    for (size_t i = 0; i < prelude.headers; ++i) {
+        const HeaderEntry& entry = *ctx.include_sources[i];
+        out.putString(entry.path);
+        out.put(static_cast<int64_t>(entry.modified.time_since_epoch().count()));
+        out.put(static_cast<uint64_t>(entry.size));
+        out.putString(entry.guard);
+        out.put(static_cast<uint32_t>(entry.lines.lineStarts().size()));
+        for (uint32_t start : entry.lines.lineStarts()) {
+            out.put(start);
+        }
+    }
+    out.put(static_cast<uint32_t>(macros.size()));
+    for (const auto& [name, value] : macros) {
+        out.putString(name);
+        out.putString(value);
+    }
+    out.put(static_cast<uint32_t>(includes));
+    for (size_t i = 0; i < includes; ++i) {
+        out.putString(ctx.included_files[i]);
+    }
+    out.put(static_cast<uint32_t>(conditions.size()));
+    for (const Conditional& conditional : conditions) {
+        out.put(conditional.offset);
+        out.put(static_cast<uint8_t>(conditional.else_seen));
+    }
+    out.put(static_cast<uint32_t>(tokens.size()));
+    for (const Tokens& token : tokens) {
+        out.put(token);
+    }
+    out.put(static_cast<uint32_t>(unknown.size()));
+    for (const UnknownTokens& token : unknown) {
+        out.put(token.lexeme);
+        out.put(token.offset);
+        out.put(token.file);
+    }
+
+    std::string temporary = ctx.pch_path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.bytes().data(), static_cast<std::streamsize>(out.bytes().size()))) {
+            std::cerr << "Error: Could not write prelude snapshot " << ctx.pch_path << "\n";
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, ctx.pch_path, error);
+    if (error) {
+        std::cerr << "Error: Could not write prelude snapshot " << ctx.pch_path << "\n";
+        fs::remove(temporary, error);
+        return false;
+    }
+    UC_TRACE(TraceLevel::Info, TraceCategory::Lexer, "Saved prelude snapshot " << ctx.pch_path << " ("
+             << prelude.tokens << " tokens, " << prelude.headers << " headers)");
+    return true;
+}
+
+bool loadPreludeSnapshot(FrontendContext& ctx, uint32_t& resume) {
+    ctx.snapshot.close();
+    if (!ctx.source.isOpen() || !ctx.snapshot.open(ctx.pch_path)) {
+        return false;
+    }
+    auto reject = [&](const char* reason) {
+        UC_TRACE(TraceLevel::Info, TraceCategory::Lexer, "Not using prelude snapshot " << ctx.pch_path << ": " << reason);
+        ctx.snapshot.close();
+        return false;
+    };
+
+    Reader in(ctx.snapshot.data(), ctx.snapshot.data() + ctx.snapshot.size());
+    SnapshotHeader header = in.get<SnapshotHeader>();
+    if (!in.ok() || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.tokenBytes != sizeof(Tokens) || header.reservedLexemes != kReservedLexemeCount) {
+        return reject("not a snapshot from this version");
+    }
+    if (header.preludeBytes > ctx.source.size()
+        || fnv1a(ctx.source.view().substr(0, header.preludeBytes)) != header.preludeHash) {
+        return reject("the prelude differs");
+    }
+
+    std::vector<std::string_view> spellings(in.get<uint32_t>());
+    for (std::string_view& spelling : spellings) {
+        spelling = in.getString();
+    }
+    bool samePath = in.getString() == sourceDirectory(ctx) && in.get<uint32_t>() == ctx.include_dirs.size();
+    for (size_t i = 0; samePath && i < ctx.include_dirs.size(); ++i) {
+        samePath = in.getString() == ctx.include_dirs[i];
+    }
+    if (!samePath) {
+        return reject("the include path differs");
+    }
+
+    std::vector<std::shared_ptr<const HeaderEntry>> headers(in.get<uint32_t>());
+    for (auto& slot : headers) {
+        // Enough of an entry to resolve positions; its tokens are already in the snapshot
+        auto entry = std::make_shared<HeaderEntry>();
+        entry->path = std::string(in.getString());
+        entry->modified = fs::file_time_type(fs::file_time_type::duration(in.get<int64_t>()));
+        entry->size = in.get<uint64_t>();
+        entry->guard = std::string(in.getString());
+        std::vector<uint32_t> starts(in.get<uint32_t>());
+        for (uint32_t& start : starts) {
+            start = in.get<uint32_t>();
+        }
+        entry->lines.assign(std::move(starts));
+        std::error_code error;
+        if (!in.ok() || fs::last_write_time(entry->path, error) != entry->modified || error
+            || fs::file_size(entry->path, error) != entry->size || error) {
+            return reject("a header changed");
+        }
+        slot = std::move(entry);
+    }
+
+    std::unordered_map<std::string, std::string> macros;
+    for (uint32_t count = in.get<uint32_t>(); in.ok() && count > 0; --count) {
+        std::string name(in.getString());
+        macros[name] = std::string(in.getString());
+    }
+    std::vector<std::string> includedFiles(in.get<uint32_t>());
+    for (std::string& file : includedFiles) {
+        file = std::string(in.getString());
+    }
+    std::vector<Conditional> conditions(in.get<uint32_t>());
+    for (Conditional& conditional : conditions) {
+        conditional.offset = in.get<uint32_t>();
+        conditional.taken = true; // The prelude ends in active code
+        conditional.else_seen = in.get<uint8_t>() != 0;
+    }
+    std::vector<Tokens> tokens(in.get<uint32_t>());
+    for (Tokens& token : tokens) {
+        token = in.get<Tokens>();
+    }
+    std::vector<UnknownTokens> unknown(in.get<uint32_t>());
+    for (UnknownTokens& token : unknown) {
+        token.lexeme = in.get<uint32_t>();
+        token.offset = in.get<uint32_t>();
+        token.file = in.get<uint16_t>();
+    }
+    if (!in.ok()) {
+        return reject("it is truncated");
+    }
+
+    uint32_t limit = kReservedLexemeCount + static_cast<uint32_t>(spellings.size());
+    auto validLexeme = [&](uint32_t id) { return id < limit || id == StringPool::kEmptyId; };
+    bool valid = true;
+    for (const Tokens& token : tokens) {
+        valid = valid && validLexeme(token.lexeme) && token.file <= headers.size();
+    }
+    for (const UnknownTokens& token : unknown) {
+        valid = valid && validLexeme(token.lexeme) && token.file != 0 && token.file <= headers.size();
+    }
+    if (!valid) {
+        return reject("it is corrupt");
+    }
+
+    // All checked: replace the state the scanner starts from, borrowing spellings from the mapping
+    std::vector<uint32_t> remap(spellings.size(), kUnmapped);
+    auto lexeme = [&](uint32_t id) {
+        if (id < kReservedLexemeCount || id == StringPool::kEmptyId) {
+            return id;
+        }
+        uint32_t& mapped = remap[id - kReservedLexemeCount];
+        if (mapped == kUnmapped) {
+            mapped = ctx.strings.intern_borrowed(spellings[id - kReservedLexemeCount]);
+        }
+        return mapped;
+    };
+    for (Tokens& token : tokens) {
+        token.lexeme = lexeme(token.lexeme);
+    }
+    for (UnknownTokens& token : unknown) {
+        token.lexeme = lexeme(token.lexeme);
+    }
+    ctx.tokens = std::move(tokens);
+    ctx.unknown_tokens = std::move(unknown);
+    ctx.macros = std::move(macros);
+    ctx.included_files = std::move(includedFiles);
+    ctx.conditions = std::move(conditions);
+    ctx.include_sources = std::move(headers);
+    ctx.include_guards.clear();
+    for (const auto& entry : ctx.include_sources) {
+        if (!entry->guard.empty()) {
+            ctx.include_guards[entry->path] = entry->guard;
+        }
+    }
+    resume = header.preludeBytes;
+    UC_TRACE(TraceLevel::Info, TraceCategory::Lexer, "Loaded prelude snapshot " << ctx.pch_path << " ("
+             << ctx.tokens.size() << " tokens, resuming at byte " << resume << ")");
+    return true;
+}
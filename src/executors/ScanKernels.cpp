@@ -0,0 +1,291 @@
+#include "../include/ScanKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_KERNELS_X86 1
+#endif
+
+namespace {
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Scalar versions; the SIMD kernels also use them for the last partial block
+
+const char* skipBlanksScalar(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+const char* skipIdentifierScalar(const char* p, const char* end) {
+    while (p < end && isIdentifierChar(*p)) ++p;
+    return p;
+}
+
+const char* findByteScalar(const char* p, const char* end, char c) {
+    while (p < end && *p != c) ++p;
+    return p;
+}
+
+const char* findCommentEndScalar(const char* p, const char* end) {
+    for (; p + 1 < end; ++p) {
+        if (p[0] == '*' && p[1] == '/') return p + 2;
+    }
+    return nullptr;
+}
+
+// Shared by every width once a quote or backslash has been located at p
+inline const char* stringStop(const char*& p, const char* end, char quote) {
+    if (*p == quote) return p + 1;
+    // Backslash: (\\.) takes the next byte, which may not be a newline
+    if (p + 1 >= end || p[1] == '\n') return nullptr;
+    p += 2;
+    return p; // Not a stop, keep scanning from here
+}
+
+const char* findStringEndScalar(const char* p, const char* end, char quote) {
+    while (p < end) {
+        if (*p == quote || *p == '\\') {
+            const char* resume = p;
+            const char* stop = stringStop(resume, end, quote);
+            if (stop != resume) return stop;
+            p = resume;
+        } else {
+            ++p;
+        }
+    }
+    return nullptr;
+}
+
+size_t countNewlinesScalar(const char* p, const char* end) {
+    size_t count = 0;
+    for (; p < end; ++p) count += (*p == '\n');
+    return count;
+}
+
+#ifdef SCAN_KERNELS_X86
+
+// SSE2 (baseline on x86-64): 16 bytes per step
+
+inline unsigned blankMask16(__m128i v) {
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    return static_cast<unsigned>(_mm_movemask_epi8(m));
+}
+
+// Signed byte compares; bytes >= 0x80 are negative and fall outside every range
+inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+inline unsigned identifierMask16(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // Folds A-Z onto a-z
+    __m128i m = _mm_or_si128(_mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(v, '0', '9')),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    return static_cast<unsigned>(_mm_movemask_epi8(m));
+}
+
+inline __m128i load16(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+const char* skipBlanksSSE2(const char* p, const char* end) {
+    for (; p + 16 <= end; p += 16) {
+        unsigned stop = ~blankMask16(load16(p)) & 0xFFFF;
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipBlanksScalar(p, end);
+}
+
+const char* skipIdentifierSSE2(const char* p, const char* end) {
+    for (; p + 16 <= end; p += 16) {
+        unsigned stop = ~identifierMask16(load16(p)) & 0xFFFF;
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipIdentifierScalar(p, end);
+}
+
+const char* findByteSSE2(const char* p, const char* end, char c) {
+    __m128i needle = _mm_set1_epi8(c);
+    for (; p + 16 <= end; p += 16) {
+        unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(load16(p), needle)));
+        if (hit) return p + __builtin_ctz(hit);
+    }
+    return findByteScalar(p, end, c);
+}
+
+const char* findCommentEndSSE2(const char* p, const char* end) {
+    __m128i star = _mm_set1_epi8('*');
+    __m128i slash = _mm_set1_epi8('/');
+    // Compare each byte and its successor at once: a hit is a '*' followed by '/'
+    for (; p + 17 <= end; p += 16) {
+        __m128i pair = _mm_and_si128(_mm_cmpeq_epi8(load16(p), star), _mm_cmpeq_epi8(load16(p + 1), slash));
+        unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(pair));
+        if (hit) return p + __builtin_ctz(hit) + 2;
+    }
+    return findCommentEndScalar(p, end);
+}
+
+const char* findStringEndSSE2(const char* p, const char* end, char quote) {
+    __m128i q = _mm_set1_epi8(quote);
+    __m128i backslash = _mm_set1_epi8('\\');
+    while (p + 16 <= end) {
+        __m128i v = load16(p);
+        unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, backslash))));
+        if (!hit) {
+            p += 16;
+            continue;
+        }
+        p += __builtin_ctz(hit);
+        const char* resume = p;
+        const char* stop = stringStop(resume, end, quote);
+        if (stop != resume) return stop;
+        p = resume;
+    }
+    return findStringEndScalar(p, end, quote);
+}
+
+size_t countNewlinesSSE2(const char* p, const char* end) {
+    __m128i nl = _mm_set1_epi8('\n');
+    size_t count = 0;
+    for (; p + 16 <= end; p += 16) {
+        count += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(load16(p), nl))));
+    }
+    return count + countNewlinesScalar(p, end);
+}
+
+// AVX2: 32 bytes per step, compiled for that target only and picked at runtime
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256i load32(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+AVX2_TARGET inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+AVX2_TARGET const char* skipBlanksAVX2(const char* p, const char* end) {
+    for (; p + 32 <= end; p += 32) {
+        __m256i v = load32(p);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipBlanksSSE2(p, end);
+}
+
+AVX2_TARGET const char* skipIdentifierAVX2(const char* p, const char* end) {
+    for (; p + 32 <= end; p += 32) {
+        __m256i v = load32(p);
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(v, '0', '9')),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipIdentifierSSE2(p, end);
+}
+
+AVX2_TARGET const char* findByteAVX2(const char* p, const char* end, char c) {
+    __m256i needle = _mm256_set1_epi8(c);
+    for (; p + 32 <= end; p += 32) {
+        unsigned hit = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(p), needle)));
+        if (hit) return p + __builtin_ctz(hit);
+    }
+    return findByteSSE2(p, end, c);
+}
+
+AVX2_TARGET const char* findCommentEndAVX2(const char* p, const char* end) {
+    __m256i star = _mm256_set1_epi8('*');
+    __m256i slash = _mm256_set1_epi8('/');
+    for (; p + 33 <= end; p += 32) {
+        __m256i pair = _mm256_and_si256(_mm256_cmpeq_epi8(load32(p), star), _mm256_cmpeq_epi8(load32(p + 1), slash));
+        unsigned hit = static_cast<unsigned>(_mm256_movemask_epi8(pair));
+        if (hit) return p + __builtin_ctz(hit) + 2;
+    }
+    return findCommentEndSSE2(p, end);
+}
+
+AVX2_TARGET const char* findStringEndAVX2(const char* p, const char* end, char quote) {
+    __m256i q = _mm256_set1_epi8(quote);
+    __m256i backslash = _mm256_set1_epi8('\\');
+    while (p + 32 <= end) {
+        __m256i v = load32(p);
+        unsigned hit = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, backslash))));
+        if (!hit) {
+            p += 32;
+            continue;
+        }
+        p += __builtin_ctz(hit);
+        const char* resume = p;
+        const char* stop = stringStop(resume, end, quote);
+        if (stop != resume) return stop;
+        p = resume;
+    }
+    return findStringEndSSE2(p, end, quote);
+}
+
+AVX2_TARGET size_t countNewlinesAVX2(const char* p, const char* end) {
+    __m256i nl = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    for (; p + 32 <= end; p += 32) {
+        count += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(p), nl))));
+    }
+    return count + countNewlinesSSE2(p, end);
+}
+
+#undef AVX2_TARGET
+
+#endif // SCAN_KERNELS_X86
+
+const ScanKernels kScalarKernels = {
+    "scalar", skipBlanksScalar, skipIdentifierScalar, findByteScalar,
+    findCommentEndScalar, findStringEndScalar, countNewlinesScalar
+};
+
+#ifdef SCAN_KERNELS_X86
+const ScanKernels kSSE2Kernels = {
+    "sse2", skipBlanksSSE2, skipIdentifierSSE2, findByteSSE2,
+    findCommentEndSSE2, findStringEndSSE2, countNewlinesSSE2
+};
+
+const ScanKernels kAVX2Kernels = {
+    "avx2", skipBlanksAVX2, skipIdentifierAVX2, findByteAVX2,
+    findCommentEndAVX2, findStringEndAVX2, countNewlinesAVX2
+};
+#endif
+
+} // namespace
+
+const ScanKernels& scalarScanKernels() {
+    return kScalarKernels;
+}
+
+#ifdef SCAN_KERNELS_X86
+const ScanKernels& sse2ScanKernels() {
+    return kSSE2Kernels;
+}
+
+const ScanKernels* avx2ScanKernels() {
+    return __builtin_cpu_supports("avx2") ? &kAVX2Kernels : nullptr;
+}
+#endif
+
+const ScanKernels& scanKernels() {
+#ifdef SCAN_KERNELS_X86
+    static const ScanKernels& best = avx2ScanKernels() ? *avx2ScanKernels() : sse2ScanKernels();
+    return best;
+#else
+    return scalarScanKernels();
+#endif
+}
@@ -10,7 +10,12 @@
 #include <ctime>
 #include <cstring>
 
-SemanticAnalyzer::SemanticAnalyzer(std::shared_ptr<ASTNode> a) : ast(a), tempCounter(1), labelCounter(1), dagNodeCounter(1), registerCounter(0) {
+// Table cell text: anything longer than limit is cut to limit - 3 characters plus "..."
+static std::string truncated(std::string_view text, size_t limit) {
+    return text.length() > limit ? std::string(text.substr(0, limit - 3)) + "..." : std::string(text);
+}
+
+SemanticAnalyzer::SemanticAnalyzer(AST a) : ast(std::move(a)), tempCounter(1), labelCounter(1), dagNodeCounter(1), registerCounter(0) {
     registers = {"r1", "r2", "r3", "r4"};
     functionSignatures = {
         {"printf", {{"string"}, {"string", "int"}, {"string", "float"}}},
@@ -18,22 +23,22 @@ SemanticAnalyzer::SemanticAnalyzer(std::shared_ptr<ASTNode> a) : ast(a), tempCou
     };
 }
 
-std::string SemanticAnalyzer::newTemp() {
+Name SemanticAnalyzer::newTemp() {
     return "t" + std::to_string(tempCounter++);
 }
 
-std::string SemanticAnalyzer::newLabel() {
+Name SemanticAnalyzer::newLabel() {
     return "L" + std::to_string(labelCounter++);
 }
 
-std::string SemanticAnalyzer::allocateRegister() {
+Name SemanticAnalyzer::allocateRegister() {
     if (registerCounter < registers.size()) {
         return registers[registerCounter++];
     }
     return newTemp();
 }
 
-void SemanticAnalyzer::freeRegister(const std::string& reg) {
+void SemanticAnalyzer::freeRegister(Name reg) {
     auto it = std::find(registers.begin(), registers.end(), reg);
     if (it != registers.end()) {
         registerCounter--;
@@ -41,7 +46,7 @@ void SemanticAnalyzer::freeRegister(const std::string& reg) {
     }
 }
 
-std::shared_ptr<DAGNode> SemanticAnalyzer::findDAGNode(const std::string& op, const std::string& arg1, const std::string& arg2) {
+std::shared_ptr<DAGNode> SemanticAnalyzer::findDAGNode(Name op, Name arg1, Name arg2) {
     for (const auto& node : dagNodes) {
         if (node->op == op && node->children.size() == 2 &&
             node->children[0]->value == arg1 && node->children[1]->value == arg2) {
@@ -51,8 +56,8 @@ std::shared_ptr<DAGNode> SemanticAnalyzer::findDAGNode(const std::string& op, co
     return nullptr;
 }
 
-std::shared_ptr<DAGNode> SemanticAnalyzer::createDAGNode(const std::string& op, const std::string& value,
-                                                        const std::vector<std::string>& args, int line) {
+std::shared_ptr<DAGNode> SemanticAnalyzer::createDAGNode(Name op, Name value,
+                                                        const std::vector<Name>& args, int line) {
     std::shared_ptr<DAGNode> node = std::make_shared<DAGNode>(op, value, dagNodeCounter++);
     for (const auto& arg : args) {
         bool found = false;
@@ -64,7 +69,7 @@ std::shared_ptr<DAGNode> SemanticAnalyzer::createDAGNode(const std::string& op,
             }
         }
         if (!found) {
-            auto leaf = std::make_shared<DAGNode>("", arg, dagNodeCounter++);
+            auto leaf = std::make_shared<DAGNode>(Name(), arg, dagNodeCounter++);
             node->children.push_back(leaf);
             dagNodes.push_back(leaf);
         }
@@ -73,93 +78,150 @@ std::shared_ptr<DAGNode> SemanticAnalyzer::createDAGNode(const std::string& op,
     return node;
 }
 
-void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
-    switch (node->type) {
+namespace {
+
+// Runs one of SemanticAnalyzer's *Step members over a tree as an ASTVisitor pass
+template <void (SemanticAnalyzer::*Step)(ASTWalk&, ASTRef, uint32_t)>
+class AnalyzerPass : public ASTVisitor<AnalyzerPass<Step>> {
+private:
+    SemanticAnalyzer& analyzer;
+
+public:
+    AnalyzerPass(SemanticAnalyzer& owner, ASTWalkStack& frames)
+        : ASTVisitor<AnalyzerPass>(frames), analyzer(owner) {}
+
+    void visit(ASTRef node, uint32_t step) { (analyzer.*Step)(*this, node, step); }
+};
+
+// Steps of a node in the passes below. Each pass starts a node at kFirstVisit; a node that needs
+// to act again once its children are done schedules one of the later steps.
+constexpr uint32_t kFirstVisit = 0;
+constexpr uint32_t kAfterChildren = 1;
+constexpr uint32_t kAfterThen = 1;  // IfElse: the then branch is done
+constexpr uint32_t kAfterElse = 2;  // IfElse: the else branch is done
+
+// Schedules a binary operator's two operands, then the operator itself again
+void visitOperands(ASTWalk& walk, ASTRef node) {
+    walk.visitChild(node.child(0));
+    walk.visitChild(node.child(1));
+    walk.resume(node, kAfterChildren);
+}
+
+}
+
+Name SemanticAnalyzer::takeExpressionValue() {
+    Name value = expressionValues.back();
+    expressionValues.pop_back();
+    return value;
+}
+
+void SemanticAnalyzer::analyzeNode(ASTRef node) {
+    AnalyzerPass<&SemanticAnalyzer::analyzeStep>(*this, walkStack).run(node);
+}
+
+void SemanticAnalyzer::analyzeStep(ASTWalk& walk, ASTRef node, uint32_t step) {
+    switch (node.type()) {
         case NodeType::Program:
-            for (const auto& child : node->children) {
-                analyzeNode(child);
+            if (step == kFirstVisit) {
+                walk.visitChildren(node);
+                walk.resume(node, kAfterChildren);
+            } else {
+                symbolTable.checkUnusedSymbols();
             }
-            symbolTable.checkUnusedSymbols();
             break;
 
         case NodeType::Preprocessor: {
-            if (node->value == "#include <stdio.h>") {
+            if (node.value() == "#include <stdio.h>") {
                 symbolTable.setStdioInclude();
                 symbolTable.addTypeCheck("#include <stdio.h>", "Standard I/O included", "OK");
-            } else if (node->value.find("#define") == 0) {
-                size_t spacePos = node->value.find(" ", 8);
+            } else if (node.value().view().find("#define") == 0) {
+                std::string_view directive = node.value().view();
+                size_t spacePos = directive.find(" ", 8);
                 if (spacePos == std::string::npos) {
-                    issues.emplace_back("Error", "Invalid macro definition at line " + std::to_string(node->line), "❌");
+                    issues.emplace_back("Error", "Invalid macro definition at line " + std::to_string(node.line()), "❌");
                     break;
                 }
-                std::string macroName = node->value.substr(8, spacePos - 8);
-                std::string macroValue = node->value.substr(spacePos + 1);
-                symbolTable.defineMacro(macroName, macroValue, node->line);
+                Name macroName = directive.substr(8, spacePos - 8);
+                std::string macroValue(directive.substr(spacePos + 1));
+                symbolTable.defineMacro(macroName, macroValue, node.line());
             } else {
-                issues.emplace_back("Error", "Invalid preprocessor directive at line " + std::to_string(node->line), "❌");
+                issues.emplace_back("Error", "Invalid preprocessor directive at line " + std::to_string(node.line()), "❌");
             }
             break;
         }
 
         case NodeType::Struct: {
-            symbolTable.defineStruct(node->value, node->line);
+            symbolTable.defineStruct(node.value(), node.line());
             break;
         }
 
         case NodeType::Function: {
-            analyzeFunction(node);
+            if (step == kAfterChildren) {
+                // Exit function scope
+                symbolTable.exitFunction();
+                currentFunctionReturnType = Name();
+                break;
+            }
+
+            // Extract function name and return type
+            Name funcName = node.value();
+            Name returnType = node.typeHint().empty() ? "void" : node.typeHint();
+
+            // Enter function scope
+            symbolTable.enterFunction(funcName);
+            currentFunctionReturnType = returnType;
+
+            // Collect parameters if any
+            std::vector<Name> paramTypes;
+            // TODO: Parse parameters from node.value() if present (e.g., "main (int argc, char** argv)")
+
+            // Define function in symbol table
+            symbolTable.defineFunction(funcName, returnType, paramTypes, node.line());
+
+            // Analyze function body
+            walk.visitChildren(node);
+            walk.resume(node, kAfterChildren);
             break;
         }
 
         case NodeType::Declarations: {
-            for (const auto& child : node->children) {
-                if (child->type == NodeType::VarDecl) {
+            for (ASTRef child : node.children()) {
+                if (child.type() == NodeType::VarDecl) {
                     analyzeVarDecl(child);
                 } else {
-                    issues.emplace_back("Error", "Invalid child node in Declarations at line " + std::to_string(child->line), "❌");
+                    issues.emplace_back("Error", "Invalid child node in Declarations at line " + std::to_string(child.line()), "❌");
                 }
             }
             break;
         }
 
-        case NodeType::LocalDeclaration: {
-            if (node->value == "declarations") {
-                for (const auto& child : node->children) {
-                    analyzeNode(child);
-                }
-            } else {
-                analyzeNode(node);
-            }
-            break;
-        }
-
         case NodeType::VarDecl: {
             analyzeVarDecl(node);
             break;
         }
 
         case NodeType::Assignment: {
-            auto symbol = symbolTable.lookup(node->value, node->line);
+            auto symbol = symbolTable.lookup(node.value(), node.line());
             if (!symbol) {
                 issues.emplace_back(
                     "Error",
-                    "Undeclared variable '" + node->value + "' in assignment at line " + std::to_string(node->line),
+                    "Undeclared variable '" + node.value() + "' in assignment at line " + std::to_string(node.line()),
                     "❌"
                 );
                 break;
             }
-            symbolTable.markUsed(node->value);
-            std::string exprType = getExpressionType(node->children[0]);
+            symbolTable.markUsed(node.value());
+            Name exprType = getExpressionType(node.child(0));
             if (exprType == symbol->type || (exprType == "int" && symbol->type == "float")) {
                 symbolTable.addTypeCheck(
-                    node->value + " = " + node->children[0]->value,
+                    node.value() + " = " + node.child(0).value(),
                     "Assigning " + exprType + " expression to " + symbol->type + " variable",
                     "OK"
                 );
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Assignment type mismatch for '" + node->value + "' at line " + std::to_string(node->line) +
+                    "Assignment type mismatch for '" + node.value() + "' at line " + std::to_string(node.line()) +
                     ". Expected " + symbol->type + ", got " + exprType,
                     "❌"
                 );
@@ -173,14 +235,14 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
         }
 
         case NodeType::Call: {
-            std::string funcName = node->value;
+            Name funcName = node.value();
             auto it = functionSignatures.find(funcName);
             if (it == functionSignatures.end()) {
-                auto symbol = symbolTable.lookup(funcName, node->line);
+                auto symbol = symbolTable.lookup(funcName, node.line());
                 if (!symbol || symbol->attributes != "function") {
                     issues.emplace_back(
                         "Error",
-                        "Unknown function '" + funcName + "' at line " + std::to_string(node->line),
+                        "Unknown function '" + funcName + "' at line " + std::to_string(node.line()),
                         "❌"
                     );
                     break;
@@ -195,15 +257,15 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
                 symbolTable.markUsed(funcName);
                 bool valid = false;
                 for (const auto& expectedTypes : it->second) {
-                    if (node->children.size() == expectedTypes.size()) {
+                    if (node.childCount() == expectedTypes.size()) {
                         bool argsMatch = true;
-                        for (size_t i = 0; i < node->children.size(); ++i) {
-                            std::string actualType = getExpressionType(node->children[i]);
+                        for (size_t i = 0; i < node.childCount(); ++i) {
+                            Name actualType = getExpressionType(node.child(i));
                             if (actualType == "unknown") {
                                 issues.emplace_back(
                                     "Error",
                                     "Unknown type for argument " + std::to_string(i + 1) + " in call to '" + funcName +
-                                    "' at line " + std::to_string(node->line),
+                                    "' at line " + std::to_string(node.line()),
                                     "❌"
                                 );
                                 argsMatch = false;
@@ -214,7 +276,7 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
                                     "Error",
                                     "Type mismatch for argument " + std::to_string(i + 1) + " in call to '" + funcName +
                                     "'. Expected " + expectedTypes[i] + ", got " + actualType + " at line " +
-                                    std::to_string(node->line),
+                                    std::to_string(node.line()),
                                     "❌"
                                 );
                                 argsMatch = false;
@@ -229,7 +291,7 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
                                 if (i < expectedTypes.size() - 1) argsDesc += ", ";
                             }
                             symbolTable.addTypeCheck(
-                                funcName + "(" + (node->children.empty() ? "" : node->children[0]->value) + ")",
+                                funcName + "(" + (node.hasChildren() ? node.child(0).value() : "") + ")",
                                 argsDesc,
                                 "OK"
                             );
@@ -240,7 +302,7 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
                 if (!valid) {
                     issues.emplace_back(
                         "Error",
-                        "Invalid arguments for '" + funcName + "' at line " + std::to_string(node->line),
+                        "Invalid arguments for '" + funcName + "' at line " + std::to_string(node.line()),
                         "❌"
                     );
                 }
@@ -249,46 +311,46 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
         }
 
         case NodeType::IfElse: {
-            if (node->children.size() != 3) {
+            if (node.childCount() != 3) {
                 issues.emplace_back(
                     "Error",
-                    "IfElse node must have exactly 3 children at line " + std::to_string(node->line),
+                    "IfElse node must have exactly 3 children at line " + std::to_string(node.line()),
                     "❌"
                 );
                 break;
             }
-            auto condition = node->children[2];
-            std::string condType = getExpressionType(condition);
+            auto condition = node.child(2);
+            Name condType = getExpressionType(condition);
             if (condType != "bool") {
                 issues.emplace_back(
                     "Error",
-                    "If condition must be boolean at line " + std::to_string(node->line) + ". Got " + condType,
+                    "If condition must be boolean at line " + std::to_string(node.line()) + ". Got " + condType,
                     "❌"
                 );
             } else {
                 symbolTable.addTypeCheck(
-                    node->value,
+                    node.value().str(),
                     "If condition evaluates to bool",
                     "OK"
                 );
             }
-            analyzeNode(node->children[0]);
-            analyzeNode(node->children[1]);
+            walk.visitChild(node.child(0));
+            walk.visitChild(node.child(1));
             break;
         }
 
         case NodeType::Return: {
-            std::string returnType = getExpressionType(node->children[0]);
-            if (returnType == node->typeHint || (returnType == "int" && node->typeHint == "float")) {
+            Name returnType = getExpressionType(node.child(0));
+            if (returnType == node.typeHint() || (returnType == "int" && node.typeHint() == "float")) {
                 symbolTable.addTypeCheck(
-                    "return " + node->children[0]->value,
-                    "Returning " + returnType + " from function expecting " + node->typeHint,
+                    "return " + node.child(0).value(),
+                    "Returning " + returnType + " from function expecting " + node.typeHint(),
                     "OK"
                 );
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Return type mismatch at line " + std::to_string(node->line) + ". Expected " + node->typeHint + ", got " + returnType,
+                    "Return type mismatch at line " + std::to_string(node.line()) + ". Expected " + node.typeHint() + ", got " + returnType,
                     "❌"
                 );
             }
@@ -296,45 +358,45 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
         }
 
         case NodeType::Increment: {
-            if (node->children.empty()) {
+            if (!node.hasChildren()) {
                 issues.emplace_back(
                     "Error",
-                    "Increment node missing identifier child at line " + std::to_string(node->line),
+                    "Increment node missing identifier child at line " + std::to_string(node.line()),
                     "❌"
                 );
                 break;
             }
-            auto identifierNode = node->children[0];
-            if (identifierNode->type != NodeType::Identifier) {
+            auto identifierNode = node.child(0);
+            if (identifierNode.type() != NodeType::Identifier) {
                 issues.emplace_back(
                     "Error",
-                    "Increment node child must be Identifier at line " + std::to_string(node->line),
+                    "Increment node child must be Identifier at line " + std::to_string(node.line()),
                     "❌"
                 );
                 break;
             }
-            auto symbol = symbolTable.lookup(identifierNode->value, node->line);
+            auto symbol = symbolTable.lookup(identifierNode.value(), node.line());
             if (!symbol) {
                 issues.emplace_back(
                     "Error",
-                    "Undeclared variable '" + identifierNode->value + "' in increment at line " + std::to_string(node->line),
+                    "Undeclared variable '" + identifierNode.value() + "' in increment at line " + std::to_string(node.line()),
                     "❌"
                 );
                 break;
             }
-            symbolTable.markUsed(identifierNode->value);
+            symbolTable.markUsed(identifierNode.value());
             if (symbol->type == "int" || symbol->type == "float") {
                 symbolTable.addTypeCheck(
-                    identifierNode->value + "++",
+                    identifierNode.value() + "++",
                     "Post-increment of " + symbol->type,
                     "OK"
                 );
-                node->cachedType = symbol->type;
-                identifierNode->cachedType = symbol->type;
+                node.setCachedType(symbol->type);
+                identifierNode.setCachedType(symbol->type);
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Increment requires int or float operand at line " + std::to_string(node->line) + ". Got " + symbol->type,
+                    "Increment requires int or float operand at line " + std::to_string(node.line()) + ". Got " + symbol->type,
                     "❌"
                 );
             }
@@ -342,19 +404,19 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
         }
 
         case NodeType::Identifier: {
-            auto symbol = symbolTable.lookup(node->value, node->line);
+            auto symbol = symbolTable.lookup(node.value(), node.line());
             if (!symbol) {
                 issues.emplace_back(
                     "Error",
-                    "Undeclared variable '" + node->value + "' at line " + std::to_string(node->line),
+                    "Undeclared variable '" + node.value() + "' at line " + std::to_string(node.line()),
                     "❌"
                 );
             } else {
-                symbolTable.markUsed(node->value);
-                node->cachedType = symbol->type;
+                symbolTable.markUsed(node.value());
+                node.setCachedType(symbol->type);
                 symbolTable.addTypeCheck(
-                    node->value,
-                    "Using variable '" + node->value + "' of type " + symbol->type,
+                    node.value().str(),
+                    "Using variable '" + node.value() + "' of type " + symbol->type,
                     "OK"
                 );
             }
@@ -362,35 +424,41 @@ void SemanticAnalyzer::analyzeNode(const std::shared_ptr<ASTNode>& node) {
         }
 
         default:
-            for (const auto& child : node->children) {
-                analyzeNode(child);
-            }
+            // LocalDeclaration lands here too: the readers turn "int declarations" into a
+            // Declarations node, so any other is just a list of statements
+            walk.visitChildren(node);
             break;
     }
 }
 
-std::string SemanticAnalyzer::getExpressionType(const std::shared_ptr<ASTNode>& node) {
-    if (!node->cachedType.empty()) {
-        return node->cachedType;
+Name SemanticAnalyzer::getExpressionType(ASTRef node) {
+    AnalyzerPass<&SemanticAnalyzer::expressionTypeStep>(*this, walkStack).run(node);
+    return takeExpressionValue();
+}
+
+void SemanticAnalyzer::expressionTypeStep(ASTWalk& walk, ASTRef node, uint32_t step) {
+    if (step == kFirstVisit && !node.cachedType().empty()) {
+        expressionValues.push_back(node.cachedType());
+        return;
     }
 
-    std::string result;
-    switch (node->type) {
+    Name result;
+    switch (node.type()) {
         case NodeType::Identifier: {
-            auto symbol = symbolTable.lookup(node->value, node->line);
+            auto symbol = symbolTable.lookup(node.value(), node.line());
             if (!symbol) {
                 issues.emplace_back(
                     "Error",
-                    "Undeclared variable '" + node->value + "' at line " + std::to_string(node->line),
+                    "Undeclared variable '" + node.value() + "' at line " + std::to_string(node.line()),
                     "❌"
                 );
                 result = "unknown";
             } else {
                 result = symbol->type;
-                node->cachedType = result;
+                node.setCachedType(result);
                 symbolTable.addTypeCheck(
-                    node->value,
-                    "Expression uses variable '" + node->value + "' of type " + result,
+                    node.value().str(),
+                    "Expression uses variable '" + node.value() + "' of type " + result,
                     "OK"
                 );
             }
@@ -399,22 +467,22 @@ std::string SemanticAnalyzer::getExpressionType(const std::shared_ptr<ASTNode>&
         case NodeType::Number: {
             try {
                 std::size_t pos;
-                std::stod(node->value, &pos);
-                if (node->value.find('.') != std::string::npos && pos == node->value.length()) {
+                std::stod(node.value().str(), &pos);
+                if (node.value().view().find('.') != std::string::npos && pos == node.value().length()) {
                     result = "float";
                 } else {
                     result = "int";
                 }
-                node->cachedType = result;
+                node.setCachedType(result);
                 symbolTable.addTypeCheck(
-                    node->value,
-                    "Number literal '" + node->value + "' of type " + result,
+                    node.value().str(),
+                    "Number literal '" + node.value() + "' of type " + result,
                     "OK"
                 );
             } catch (...) {
                 issues.emplace_back(
                     "Error",
-                    "Invalid number format '" + node->value + "' at line " + std::to_string(node->line),
+                    "Invalid number format '" + node.value() + "' at line " + std::to_string(node.line()),
                     "❌"
                 );
                 result = "unknown";
@@ -423,39 +491,48 @@ std::string SemanticAnalyzer::getExpressionType(const std::shared_ptr<ASTNode>&
         }
         case NodeType::String:
             result = "string";
-            node->cachedType = result;
+            node.setCachedType(result);
             symbolTable.addTypeCheck(
-                node->value,
+                node.value().str(),
                 "String literal of type " + result,
                 "OK"
             );
             break;
         case NodeType::Address: {
-            std::string baseType = getExpressionType(node->children[0]);
+            if (step == kFirstVisit) {
+                walk.visitChild(node.child(0));
+                walk.resume(node, kAfterChildren);
+                return;
+            }
+            Name baseType = takeExpressionValue();
             if (baseType == "unknown") {
                 issues.emplace_back(
                     "Error",
-                    "Unknown type for address operand at line " + std::to_string(node->line),
+                    "Unknown type for address operand at line " + std::to_string(node.line()),
                     "❌"
                 );
                 result = "unknown*";
             } else {
                 result = baseType + "*";
                 symbolTable.addTypeCheck(
-                    "&" + node->children[0]->value,
+                    "&" + node.child(0).value(),
                     "Address-of operation yielding " + result,
                     "OK"
                 );
             }
-            node->cachedType = result;
+            node.setCachedType(result);
             break;
         }
         case NodeType::Modulo: {
-            auto leftType = getExpressionType(node->children[0]);
-            auto rightType = getExpressionType(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            auto rightType = takeExpressionValue();
+            auto leftType = takeExpressionValue();
             if (leftType == "int" && rightType == "int") {
                 symbolTable.addTypeCheck(
-                    node->value,
+                    node.value().str(),
                     "Modulo operation with int operands",
                     "OK"
                 );
@@ -463,22 +540,26 @@ std::string SemanticAnalyzer::getExpressionType(const std::shared_ptr<ASTNode>&
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Modulo requires int operands at line " + std::to_string(node->line),
+                    "Modulo requires int operands at line " + std::to_string(node.line()),
                     "❌"
                 );
                 result = "unknown";
             }
-            node->cachedType = result;
+            node.setCachedType(result);
             break;
         }
         case NodeType::Equal: {
-            auto leftType = getExpressionType(node->children[0]);
-            auto rightType = getExpressionType(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            auto rightType = takeExpressionValue();
+            auto leftType = takeExpressionValue();
             if ((leftType == rightType && leftType != "unknown") ||
                 (leftType == "int" && rightType == "float") ||
                 (leftType == "float" && rightType == "int")) {
                 symbolTable.addTypeCheck(
-                    node->value,
+                    node.value().str(),
                     "Equality comparison with compatible types (" + leftType + ", " + rightType + ")",
                     "OK"
                 );
@@ -486,47 +567,55 @@ std::string SemanticAnalyzer::getExpressionType(const std::shared_ptr<ASTNode>&
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Type mismatch in comparison at line " + std::to_string(node->line) + ". Got " + leftType + " and " + rightType,
+                    "Type mismatch in comparison at line " + std::to_string(node.line()) + ". Got " + leftType + " and " + rightType,
                     "❌"
                 );
                 result = "unknown";
             }
-            node->cachedType = result;
+            node.setCachedType(result);
             break;
         }
         case NodeType::Add: {
-            auto leftType = getExpressionType(node->children[0]);
-            auto rightType = getExpressionType(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            auto rightType = takeExpressionValue();
+            auto leftType = takeExpressionValue();
             if ((leftType == "int" && rightType == "int") ||
                 (leftType == "float" && rightType == "float") ||
                 (leftType == "int" && rightType == "float") ||
                 (leftType == "float" && rightType == "int")) {
                 result = (leftType == "float" || rightType == "float") ? "float" : "int";
                 symbolTable.addTypeCheck(
-                    node->value,
+                    node.value().str(),
                     "Addition with compatible operands (" + leftType + ", " + rightType + ") yielding " + result,
                     "OK"
                 );
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Addition requires int or float operands at line " + std::to_string(node->line) + ". Got " + leftType + " and " + rightType,
+                    "Addition requires int or float operands at line " + std::to_string(node.line()) + ". Got " + leftType + " and " + rightType,
                     "❌"
                 );
                 result = "unknown";
             }
-            node->cachedType = result;
+            node.setCachedType(result);
             break;
         }
         case NodeType::Less: {
-            auto leftType = getExpressionType(node->children[0]);
-            auto rightType = getExpressionType(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            auto rightType = takeExpressionValue();
+            auto leftType = takeExpressionValue();
             if ((leftType == "int" && rightType == "int") ||
                 (leftType == "float" && rightType == "float") ||
                 (leftType == "int" && rightType == "float") ||
                 (leftType == "float" && rightType == "int")) {
                 symbolTable.addTypeCheck(
-                    node->value,
+                    node.value().str(),
                     "Less-than comparison with compatible operands (" + leftType + ", " + rightType + ")",
                     "OK"
                 );
@@ -534,213 +623,272 @@ std::string SemanticAnalyzer::getExpressionType(const std::shared_ptr<ASTNode>&
             } else {
                 issues.emplace_back(
                     "Error",
-                    "Less-than comparison requires int or float operands at line " + std::to_string(node->line) + ". Got " + leftType + " and " + rightType,
+                    "Less-than comparison requires int or float operands at line " + std::to_string(node.line()) + ". Got " + leftType + " and " + rightType,
                     "❌"
                 );
                 result = "unknown";
             }
-            node->cachedType = result;
+            node.setCachedType(result);
             break;
         }
         case NodeType::Increment:
-            result = getExpressionType(node->children[0]);
-            node->cachedType = result;
+            if (step == kFirstVisit) {
+                walk.visitChild(node.child(0));
+                walk.resume(node, kAfterChildren);
+                return;
+            }
+            result = takeExpressionValue();
+            node.setCachedType(result);
             break;
         default:
             issues.emplace_back(
                 "Error",
-                "Unsupported expression type '" + std::to_string(static_cast<int>(node->type)) + "' at line " + std::to_string(node->line),
+                "Unsupported expression type '" + std::to_string(static_cast<int>(node.type())) + "' at line " + std::to_string(node.line()),
                 "❌"
             );
             result = "unknown";
-            node->cachedType = result;
+            node.setCachedType(result);
             break;
     }
-    return result;
+    expressionValues.push_back(result);
 }
 
-std::string SemanticAnalyzer::generateExpressionTAC(const std::shared_ptr<ASTNode>& node) {
-    switch (node->type) {
+Name SemanticAnalyzer::generateExpressionTAC(ASTRef node) {
+    AnalyzerPass<&SemanticAnalyzer::expressionTACStep>(*this, walkStack).run(node);
+    return takeExpressionValue();
+}
+
+void SemanticAnalyzer::expressionTACStep(ASTWalk& walk, ASTRef node, uint32_t step) {
+    switch (node.type()) {
         case NodeType::Identifier: {
-            if (!node->cachedType.empty()) {
-                std::string reg = allocateRegister();
-                tacInstructions.emplace_back("", "LOAD", node->value, "", reg, node->line);
-                return reg;
+            if (!node.cachedType().empty()) {
+                Name reg = allocateRegister();
+                tacInstructions.emplace_back("", "LOAD", node.value(), "", reg, node.line());
+                expressionValues.push_back(reg);
+                return;
             }
-            return node->value;
+            expressionValues.push_back(node.value());
+            return;
         }
         case NodeType::Number:
         case NodeType::String: {
-            std::string reg = allocateRegister();
-            std::string value = (node->type == NodeType::String) ? "\"" + node->value + "\"" : node->value;
-            tacInstructions.emplace_back("", "LOAD", value, "", reg, node->line);
-            return reg;
+            Name reg = allocateRegister();
+            Name value = (node.type() == NodeType::String) ? Name("\"" + node.value() + "\"") : node.value();
+            tacInstructions.emplace_back("", "LOAD", value, "", reg, node.line());
+            expressionValues.push_back(reg);
+            return;
         }
         case NodeType::Address: {
-            std::string reg = allocateRegister();
-            std::string value = "&" + node->children[0]->value;
-            tacInstructions.emplace_back("", "LOAD", value, "", reg, node->line);
-            return reg;
+            Name reg = allocateRegister();
+            Name value = "&" + node.child(0).value();
+            tacInstructions.emplace_back("", "LOAD", value, "", reg, node.line());
+            expressionValues.push_back(reg);
+            return;
         }
         case NodeType::Modulo: {
-            std::string left = generateExpressionTAC(node->children[0]);
-            std::string right = generateExpressionTAC(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            Name right = takeExpressionValue();
+            Name left = takeExpressionValue();
             auto existing = findDAGNode("MOD", left, right);
             if (existing && !existing->result.empty()) {
-                return existing->result;
+                expressionValues.push_back(existing->result);
+                return;
             }
-            std::string resultReg = allocateRegister();
-            auto dagNode = createDAGNode("MOD", "", {left, right}, node->line);
+            Name resultReg = allocateRegister();
+            auto dagNode = createDAGNode("MOD", "", {left, right}, node.line());
             dagNode->result = resultReg;
-            tacInstructions.emplace_back("", "MOD", left, right, resultReg, node->line);
+            tacInstructions.emplace_back("", "MOD", left, right, resultReg, node.line());
             freeRegister(left);
             freeRegister(right);
-            return resultReg;
+            expressionValues.push_back(resultReg);
+            return;
         }
         case NodeType::Equal: {
-            std::string left = generateExpressionTAC(node->children[0]);
-            std::string right = generateExpressionTAC(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            Name right = takeExpressionValue();
+            Name left = takeExpressionValue();
             auto existing = findDAGNode("EQ", left, right);
             if (existing && !existing->result.empty()) {
-                return existing->result;
+                expressionValues.push_back(existing->result);
+                return;
             }
-            std::string resultReg = allocateRegister();
-            auto dagNode = createDAGNode("EQ", "", {left, right}, node->line);
+            Name resultReg = allocateRegister();
+            auto dagNode = createDAGNode("EQ", "", {left, right}, node.line());
             dagNode->result = resultReg;
-            tacInstructions.emplace_back("", "EQ", left, right, resultReg, node->line);
+            tacInstructions.emplace_back("", "EQ", left, right, resultReg, node.line());
             freeRegister(left);
             freeRegister(right);
-            return resultReg;
+            expressionValues.push_back(resultReg);
+            return;
         }
         case NodeType::Add: {
-            std::string left = generateExpressionTAC(node->children[0]);
-            std::string right = generateExpressionTAC(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            Name right = takeExpressionValue();
+            Name left = takeExpressionValue();
             auto existing = findDAGNode("ADD", left, right);
             if (existing && !existing->result.empty()) {
-                return existing->result;
+                expressionValues.push_back(existing->result);
+                return;
             }
-            std::string resultReg = allocateRegister();
-            auto dagNode = createDAGNode("ADD", "", {left, right}, node->line);
+            Name resultReg = allocateRegister();
+            auto dagNode = createDAGNode("ADD", "", {left, right}, node.line());
             dagNode->result = resultReg;
-            tacInstructions.emplace_back("", "ADD", left, right, resultReg, node->line);
+            tacInstructions.emplace_back("", "ADD", left, right, resultReg, node.line());
             freeRegister(left);
             freeRegister(right);
-            return resultReg;
+            expressionValues.push_back(resultReg);
+            return;
         }
         case NodeType::Less: {
-            std::string left = generateExpressionTAC(node->children[0]);
-            std::string right = generateExpressionTAC(node->children[1]);
+            if (step == kFirstVisit) {
+                visitOperands(walk, node);
+                return;
+            }
+            Name right = takeExpressionValue();
+            Name left = takeExpressionValue();
             auto existing = findDAGNode("LT", left, right);
             if (existing && !existing->result.empty()) {
-                return existing->result;
+                expressionValues.push_back(existing->result);
+                return;
             }
-            std::string resultReg = allocateRegister();
-            auto dagNode = createDAGNode("LT", "", {left, right}, node->line);
+            Name resultReg = allocateRegister();
+            auto dagNode = createDAGNode("LT", "", {left, right}, node.line());
             dagNode->result = resultReg;
-            tacInstructions.emplace_back("", "LT", left, right, resultReg, node->line);
+            tacInstructions.emplace_back("", "LT", left, right, resultReg, node.line());
             freeRegister(left);
             freeRegister(right);
-            return resultReg;
+            expressionValues.push_back(resultReg);
+            return;
         }
         default:
             issues.emplace_back(
                 "Error",
-                "Unsupported expression type for TAC generation at line " + std::to_string(node->line),
+                "Unsupported expression type for TAC generation at line " + std::to_string(node.line()),
                 "❌"
             );
-            return "";
+            expressionValues.push_back(Name());
+            return;
     }
 }
 
-void SemanticAnalyzer::generateTAC(const std::shared_ptr<ASTNode>& node) {
-    switch (node->type) {
-        case NodeType::Program:
-            for (const auto& child : node->children) {
-                generateTAC(child);
-            }
-            break;
+void SemanticAnalyzer::generateTAC(ASTRef node) {
+    AnalyzerPass<&SemanticAnalyzer::generateTACStep>(*this, walkStack).run(node);
+}
 
+void SemanticAnalyzer::generateTACStep(ASTWalk& walk, ASTRef node, uint32_t step) {
+    switch (node.type()) {
         case NodeType::Function: {
-            std::string funcLabel = "func_" + node->value;
-            tacInstructions.emplace_back(funcLabel + ":", "", "", "", "", node->line);
+            if (step == kAfterChildren) {
+                tacInstructions.emplace_back("", "END", "", "", "", node.line());
+                break;
+            }
+            Name funcLabel = "func_" + node.value() + ":";
+            tacInstructions.emplace_back(funcLabel, "", "", "", "", node.line());
             registerCounter = 0;
             dagNodes.clear();
-            for (const auto& child : node->children) {
-                generateTAC(child);
-            }
-            tacInstructions.emplace_back("", "END", "", "", "", node->line);
+            walk.visitChildren(node);
+            walk.resume(node, kAfterChildren);
             break;
         }
 
         case NodeType::VarDecl: {
-            if (!node->children.empty()) {
-                std::string value = generateExpressionTAC(node->children[0]);
-                tacInstructions.emplace_back("", "STORE", value, "", node->value, node->line);
+            if (node.hasChildren()) {
+                Name value = generateExpressionTAC(node.child(0));
+                tacInstructions.emplace_back("", "STORE", value, "", node.value(), node.line());
             }
             break;
         }
 
         case NodeType::Assignment: {
-            std::string value = generateExpressionTAC(node->children[0]);
-            tacInstructions.emplace_back("", "STORE", value, "", node->value, node->line);
+            Name value = generateExpressionTAC(node.child(0));
+            tacInstructions.emplace_back("", "STORE", value, "", node.value(), node.line());
             break;
         }
 
         case NodeType::While: {
-            std::string startLabel = newLabel();
-            std::string endLabel = newLabel();
-            tacInstructions.emplace_back(startLabel + ":", "", "", "", "", node->line);
-            std::string cond = generateExpressionTAC(node->children[0]);
-            tacInstructions.emplace_back("", "JZ", cond, "", endLabel, node->line);
-            for (size_t i = 1; i < node->children.size(); ++i) {
-                generateTAC(node->children[i]);
+            if (step == kAfterChildren) {
+                Name endLabel = openLabels.back();
+                openLabels.pop_back();
+                Name startLabel = openLabels.back();
+                openLabels.pop_back();
+                tacInstructions.emplace_back("", "JMP", "", "", startLabel, node.line());
+                tacInstructions.emplace_back(endLabel + ":", "", "", "", "", node.line());
+                break;
             }
-            tacInstructions.emplace_back("", "JMP", "", "", startLabel, node->line);
-            tacInstructions.emplace_back(endLabel + ":", "", "", "", "", node->line);
+            Name startLabel = newLabel();
+            Name endLabel = newLabel();
+            tacInstructions.emplace_back(startLabel + ":", "", "", "", "", node.line());
+            Name cond = generateExpressionTAC(node.child(0));
+            tacInstructions.emplace_back("", "JZ", cond, "", endLabel, node.line());
+            openLabels.push_back(startLabel);
+            openLabels.push_back(endLabel);
+            walk.visitSiblings(node.child(1));
+            walk.resume(node, kAfterChildren);
             break;
         }
 
         case NodeType::Call: {
-            std::string funcName = node->value;
-            std::vector<std::string> argRegs;
-            for (const auto& child : node->children) {
-                std::string arg = generateExpressionTAC(child);
+            Name funcName = node.value();
+            std::vector<Name> argRegs;
+            for (ASTRef child : node.children()) {
+                Name arg = generateExpressionTAC(child);
                 argRegs.push_back(arg);
             }
             std::string args;
             if (!argRegs.empty()) {
-                args = argRegs[0];
+                args = argRegs[0].str();
                 for (size_t i = 1; i < argRegs.size(); ++i) {
                     args += "," + argRegs[i];
                 }
             }
-            tacInstructions.emplace_back("", "CALL", funcName, args, "", node->line);
+            tacInstructions.emplace_back("", "CALL", funcName, args, "", node.line());
             break;
         }
 
         case NodeType::IfElse: {
-            std::string elseLabel = newLabel();
-            std::string endLabel = newLabel();
-            std::string cond = generateExpressionTAC(node->children[2]);
-            tacInstructions.emplace_back("", "JZ", cond, "", elseLabel, node->line);
-            generateTAC(node->children[0]);
-            tacInstructions.emplace_back("", "JMP", "", "", endLabel, node->line);
-            tacInstructions.emplace_back(elseLabel + ":", "", "", "", "", node->line);
-            generateTAC(node->children[1]);
-            tacInstructions.emplace_back(endLabel + ":", "", "", "", "", node->line);
+            if (step == kAfterThen) {
+                Name endLabel = openLabels.back();
+                Name elseLabel = openLabels[openLabels.size() - 2];
+                tacInstructions.emplace_back("", "JMP", "", "", endLabel, node.line());
+                tacInstructions.emplace_back(elseLabel + ":", "", "", "", "", node.line());
+                walk.visitChild(node.child(1));
+                walk.resume(node, kAfterElse);
+                break;
+            }
+            if (step == kAfterElse) {
+                Name endLabel = openLabels.back();
+                openLabels.resize(openLabels.size() - 2);
+                tacInstructions.emplace_back(endLabel + ":", "", "", "", "", node.line());
+                break;
+            }
+            Name elseLabel = newLabel();
+            Name endLabel = newLabel();
+            Name cond = generateExpressionTAC(node.child(2));
+            tacInstructions.emplace_back("", "JZ", cond, "", elseLabel, node.line());
+            openLabels.push_back(elseLabel);
+            openLabels.push_back(endLabel);
+            walk.visitChild(node.child(0));
+            walk.resume(node, kAfterThen);
             break;
         }
 
         case NodeType::Return: {
-            std::string value = generateExpressionTAC(node->children[0]);
-            tacInstructions.emplace_back("", "RET", value, "", "", node->line);
+            Name value = generateExpressionTAC(node.child(0));
+            tacInstructions.emplace_back("", "RET", value, "", "", node.line());
             break;
         }
 
         default:
-            for (const auto& child : node->children) {
-                generateTAC(child);
-            }
+            walk.visitChildren(node);
             break;
     }
 }
@@ -775,11 +923,11 @@ void SemanticAnalyzer::printTAC() const {
 
         // Print instructions with improved formatting
         for (const auto& inst : tacInstructions) {
-            std::string label_trunc = inst.label.length() > 19 ? inst.label.substr(0, 16) + "..." : inst.label;
-            std::string op_trunc = inst.op.length() > 13 ? inst.op.substr(0, 10) + "..." : inst.op;
-            std::string arg1_trunc = inst.arg1.length() > 19 ? inst.arg1.substr(0, 16) + "..." : inst.arg1;
-            std::string arg2_trunc = inst.arg2.length() > 13 ? inst.arg2.substr(0, 10) + "..." : inst.arg2;
-            std::string result_trunc = inst.result.length() > 13 ? inst.result.substr(0, 10) + "..." : inst.result;
+            std::string label_trunc = truncated(inst.label.view(), 19);
+            std::string op_trunc = truncated(inst.op.view(), 13);
+            std::string arg1_trunc = truncated(inst.arg1.view(), 19);
+            std::string arg2_trunc = truncated(inst.arg2.view(), 13);
+            std::string result_trunc = truncated(inst.result.view(), 13);
 
             os << "║ " << std::left << std::setw(20) << label_trunc
                << "│ " << std::setw(14) << op_trunc
@@ -789,7 +937,7 @@ void SemanticAnalyzer::printTAC() const {
                << "│ " << std::right << std::setw(8) << inst.line << " ║\n";
 
             // Add separator after function labels for better readability
-            if (!inst.label.empty() && inst.label.find("func_") != std::string::npos) {
+            if (!inst.label.empty() && inst.label.view().find("func_") != std::string::npos) {
                 os << "╟───────────────────────┼───────────────┼───────────────────────┼───────────────┼───────────────┼─────────╢\n";
             }
         }
@@ -829,8 +977,8 @@ void SemanticAnalyzer::generateTargetCode() {
         std::vector<std::string> strings;
         int strCounter = 1;
         for (const auto& inst : tacInstructions) {
-            if (inst.op == "LOAD" && inst.arg1[0] == '"') {
-                std::string str = inst.arg1;
+            if (inst.op == "LOAD" && inst.arg1.view().substr(0, 1) == "\"") {
+                std::string str = inst.arg1.str();
                 strings.push_back(str);
                 os << "str" << strCounter++ << ": db " << str << ", 0\n";
             }
@@ -880,7 +1028,7 @@ void SemanticAnalyzer::generateTargetCode() {
                 if (inst.arg1 == "printf") {
                     size_t strIndex = 0;
                     for (size_t i = 0; i < strings.size(); ++i) {
-                        if (inst.arg2.find(strings[i]) != std::string::npos) {
+                        if (inst.arg2.view().find(strings[i]) != std::string::npos) {
                             strIndex = i + 1;
                             break;
                         }
@@ -926,94 +1074,115 @@ void SemanticAnalyzer::generateTargetCode() {
     asmFile.close();
 }
 
-void SemanticAnalyzer::printAST(const std::shared_ptr<ASTNode>& node, std::ofstream& out, int indent) const {
-    std::string indentStr(indent, ' ');
+namespace {
+
+// One line of the processed AST: the node and the types analysis found for it
+std::string describeNode(ASTRef node) {
     std::string nodeStr;
 
-    switch (node->type) {
+    switch (node.type()) {
         case NodeType::Program:
             nodeStr = "Program";
             break;
         case NodeType::Preprocessor:
-            nodeStr = "Preprocessor: " + node->value;
+            nodeStr = "Preprocessor: " + node.value();
             break;
         case NodeType::Struct:
-            nodeStr = "Struct: " + node->value;
+            nodeStr = "Struct: " + node.value();
             break;
         case NodeType::Function:
-            nodeStr = "Function: " + node->value + " (" + node->typeHint + ")";
+            nodeStr = "Function: " + node.value() + " (" + node.typeHint() + ")";
             break;
         case NodeType::LocalDeclaration:
-            nodeStr = "LocalDeclaration: " + node->typeHint + " " + node->value + " (type=" + node->typeHint + ")";
+            nodeStr = "LocalDeclaration: " + node.typeHint() + " " + node.value() + " (type=" + node.typeHint() + ")";
             break;
         case NodeType::Declarations:
             nodeStr = "Declarations";
             break;
         case NodeType::VarDecl:
-            nodeStr = "VarDecl: " + node->typeHint + " " + node->value + " (type=" + node->typeHint + ")";
+            nodeStr = "VarDecl: " + node.typeHint() + " " + node.value() + " (type=" + node.typeHint() + ")";
             break;
         case NodeType::Assignment:
-            nodeStr = "Assignment: " + node->value + " (type=" + (node->children.empty() ? "unknown" : node->children[0]->cachedType) + ")";
+            nodeStr = "Assignment: " + node.value() + " (type=" + (node.hasChildren() ? node.child(0).cachedType() : "unknown") + ")";
             break;
         case NodeType::While:
-            nodeStr = "While: " + node->value + " (type=" + (node->children.empty() ? "unknown" : node->children[0]->cachedType) + ")";
+            nodeStr = "While: " + node.value() + " (type=" + (node.hasChildren() ? node.child(0).cachedType() : "unknown") + ")";
             break;
         case NodeType::Call: {
             std::string args;
-            for (size_t i = 0; i < node->children.size(); ++i) {
-                args += node->children[i]->cachedType.empty() ? "unknown" : node->children[i]->cachedType;
-                if (i < node->children.size() - 1) args += ",";
+            for (size_t i = 0; i < node.childCount(); ++i) {
+                args += node.child(i).cachedType().empty() ? "unknown" : node.child(i).cachedType();
+                if (i < node.childCount() - 1) args += ",";
             }
-            nodeStr = "Call: " + node->callString + " (args=" + args + ")";
+            nodeStr = "Call: " + node.callString() + " (args=" + args + ")";
             break;
         }
         case NodeType::IfElse:
-            nodeStr = "IfElse: " + node->value + " (type=" + (node->children.empty() ? "unknown" : node->children[2]->cachedType) + ")";
+            nodeStr = "IfElse: " + node.value() + " (type=" + (node.hasChildren() ? node.child(2).cachedType() : "unknown") + ")";
             break;
         case NodeType::Return:
-            nodeStr = "Return: " + node->value + " (type=" + (node->children.empty() ? "unknown" : node->children[0]->cachedType) + ")";
+            nodeStr = "Return: " + node.value() + " (type=" + (node.hasChildren() ? node.child(0).cachedType() : "unknown") + ")";
             break;
         case NodeType::Identifier:
-            nodeStr = "Identifier: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Identifier: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Number:
-            nodeStr = "Number: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Number: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::String:
-            nodeStr = "String: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "String: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Address:
-            nodeStr = "Address: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Address: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Modulo:
-            nodeStr = "Modulo: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Modulo: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Equal:
-            nodeStr = "Equal: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Equal: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Add:
-            nodeStr = "Add: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Add: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Less:
-            nodeStr = "Less: " + node->value + " (type=" + (node->cachedType.empty() ? "unknown" : node->cachedType) + ")";
+            nodeStr = "Less: " + node.value() + " (type=" + (node.cachedType().empty() ? "unknown" : node.cachedType()) + ")";
             break;
         case NodeType::Increment:
-            nodeStr = "Increment: " + (node->children.empty() ? node->value : node->children[0]->value) + " (type=" + (node->children.empty() ? "unknown" : node->children[0]->cachedType) + ")";
+            nodeStr = "Increment: " + (node.hasChildren() ? node.child(0).value() : node.value()) + " (type=" + (node.hasChildren() ? node.child(0).cachedType() : "unknown") + ")";
             break;
         default:
-            nodeStr = "Unknown: " + node->value;
+            nodeStr = "Unknown: " + node.value();
             break;
     }
+    return nodeStr;
+}
+
+// Writes a tree one node per line, indented two spaces per level
+class ASTPrinter : public ASTVisitor<ASTPrinter> {
+private:
+    std::ofstream& out;
+    int indent;
+
+public:
+    ASTPrinter(ASTWalkStack& frames, std::ofstream& stream, int baseIndent)
+        : ASTVisitor(frames), out(stream), indent(baseIndent) {}
 
-    out << indentStr << nodeStr << "\n";
-    for (const auto& child : node->children) {
-        printAST(child, out, indent + 2);
+    void visit(ASTRef node, uint32_t) {
+        out << std::string(indent + 2 * depth(), ' ') << describeNode(node) << "\n";
+        visitChildren(node);
     }
+};
+
+}
+
+void SemanticAnalyzer::printAST(ASTRef node, std::ofstream& out, int indent) const {
+    ASTWalkStack frames;
+    ASTPrinter(frames, out, indent).run(node);
 }
 
 void SemanticAnalyzer::analyzeSemantics() {
-    if (ast) {
-        analyzeNode(ast);
+    if (!ast.empty()) {
+        analyzeNode(ast.root());
         symbolTable.printSymbolTable();
         symbolTable.printTypeChecks();
         symbolTable.printScopeChecks();
@@ -1033,9 +1202,9 @@ void SemanticAnalyzer::analyzeSemantics() {
 }
 
 void SemanticAnalyzer::generateTACOnly() {
-    if (ast) {
-        analyzeNode(ast);
-        generateTAC(ast);
+    if (!ast.empty()) {
+        analyzeNode(ast.root());
+        generateTAC(ast.root());
         printTAC();
         issues = symbolTable.getIssues();
         std::cout << "TAC generation completed successfully.\n";
@@ -1045,9 +1214,9 @@ void SemanticAnalyzer::generateTACOnly() {
 }
 
 void SemanticAnalyzer::generateTargetCodeOnly() {
-    if (ast) {
-        analyzeNode(ast);
-        generateTAC(ast);
+    if (!ast.empty()) {
+        analyzeNode(ast.root());
+        generateTAC(ast.root());
         generateTargetCode();
         issues = symbolTable.getIssues();
         std::cout << "Target code generation completed successfully.\n";
@@ -1056,13 +1225,13 @@ void SemanticAnalyzer::generateTargetCodeOnly() {
     }
 }
 
-void SemanticAnalyzer::saveASTToFile(const std::string& filename) const {
+void SemanticAnalyzer::saveASTToFile(const std::string& filename) {
     std::ofstream out(filename);
     if (!out.is_open()) {
         std::cerr << "Error: Failed to open " << filename << " for writing" << std::endl;
         return;
     }
-    printAST(ast, out);
+    printAST(ast.root(), out);
     out.close();
 }
 
@@ -1070,57 +1239,29 @@ const std::vector<SemanticIssue>& SemanticAnalyzer::getIssues() const {
     return issues;
 }
 
-void SemanticAnalyzer::analyzeFunction(const std::shared_ptr<ASTNode>& node) {
-    if (node->type != NodeType::Function) return;
-
-    // Extract function name and return type
-    std::string funcName = node->value;
-    std::string returnType = node->typeHint.empty() ? "void" : node->typeHint;
-    
-    // Enter function scope
-    symbolTable.enterFunction(funcName);
-    currentFunctionReturnType = returnType;
-
-    // Collect parameters if any
-    std::vector<std::string> paramTypes;
-    // TODO: Parse parameters from node->value if present (e.g., "main (int argc, char** argv)")
-
-    // Define function in symbol table
-    symbolTable.defineFunction(funcName, returnType, paramTypes, node->line);
-
-    // Analyze function body
-    for (const auto& child : node->children) {
-        analyzeNode(child);
-    }
-
-    // Exit function scope
-    symbolTable.exitFunction();
-    currentFunctionReturnType = "";
-}
-
-void SemanticAnalyzer::analyzeForLoop(const std::shared_ptr<ASTNode>& node) {
-    if (node->type != NodeType::For) return;
+void SemanticAnalyzer::analyzeForLoop(ASTRef node) {
+    if (node.type() != NodeType::For) return;
 
     // Enter new scope for the loop
     symbolTable.enterScope("for_loop");
 
-    std::string startLabel = newLabel();
-    std::string endLabel = newLabel();
+    [[maybe_unused]] Name startLabel = newLabel(); // Keeps label numbering in step with generateForLoopTAC
+    Name endLabel = newLabel();
     loopLabels.push_back(endLabel);  // For break statements
 
     // Process initialization
-    if (!node->children.empty() && node->children[0]->type == NodeType::Init) {
-        analyzeNode(node->children[0]);
+    if (node.hasChildren() && node.child(0).type() == NodeType::Init) {
+        analyzeNode(node.child(0));
     }
 
     // Generate TAC for loop
     generateForLoopTAC(node);
 
     // Analyze loop body
-    for (const auto& child : node->children) {
-        if (child->type != NodeType::Init && 
-            child->type != NodeType::Condition && 
-            child->type != NodeType::Update) {
+    for (ASTRef child : node.children()) {
+        if (child.type() != NodeType::Init && 
+            child.type() != NodeType::Condition && 
+            child.type() != NodeType::Update) {
             analyzeNode(child);
         }
     }
@@ -1130,81 +1271,81 @@ void SemanticAnalyzer::analyzeForLoop(const std::shared_ptr<ASTNode>& node) {
     loopLabels.pop_back();
 }
 
-void SemanticAnalyzer::generateForLoopTAC(const std::shared_ptr<ASTNode>& node) {
-    std::string startLabel = newLabel();
-    std::string updateLabel = newLabel();
-    std::string endLabel = newLabel();
+void SemanticAnalyzer::generateForLoopTAC(ASTRef node) {
+    Name startLabel = newLabel();
+    Name updateLabel = newLabel();
+    Name endLabel = newLabel();
 
     // Initialization
-    if (!node->children.empty() && node->children[0]->type == NodeType::Init) {
-        generateTAC(node->children[0]);
+    if (node.hasChildren() && node.child(0).type() == NodeType::Init) {
+        generateTAC(node.child(0));
     }
 
     // Loop start
-    tacInstructions.emplace_back("", "LABEL", "", "", startLabel, node->line);
+    tacInstructions.emplace_back("", "LABEL", "", "", startLabel, node.line());
 
     // Condition
-    std::string condResult;
-    for (const auto& child : node->children) {
-        if (child->type == NodeType::Condition) {
+    Name condResult;
+    for (ASTRef child : node.children()) {
+        if (child.type() == NodeType::Condition) {
             condResult = generateExpressionTAC(child);
             break;
         }
     }
-    tacInstructions.emplace_back("", "JZ", condResult, "", endLabel, node->line);
+    tacInstructions.emplace_back("", "JZ", condResult, "", endLabel, node.line());
 
     // Loop body
-    for (const auto& child : node->children) {
-        if (child->type != NodeType::Init && 
-            child->type != NodeType::Condition && 
-            child->type != NodeType::Update) {
+    for (ASTRef child : node.children()) {
+        if (child.type() != NodeType::Init && 
+            child.type() != NodeType::Condition && 
+            child.type() != NodeType::Update) {
             generateTAC(child);
         }
     }
 
     // Update
-    tacInstructions.emplace_back("", "LABEL", "", "", updateLabel, node->line);
-    for (const auto& child : node->children) {
-        if (child->type == NodeType::Update) {
+    tacInstructions.emplace_back("", "LABEL", "", "", updateLabel, node.line());
+    for (ASTRef child : node.children()) {
+        if (child.type() == NodeType::Update) {
             generateTAC(child);
             break;
         }
     }
 
     // Jump back to condition
-    tacInstructions.emplace_back("", "JMP", "", "", startLabel, node->line);
+    tacInstructions.emplace_back("", "JMP", "", "", startLabel, node.line());
     
     // Loop end
-    tacInstructions.emplace_back("", "LABEL", "", "", endLabel, node->line);
+    tacInstructions.emplace_back("", "LABEL", "", "", endLabel, node.line());
 }
 
-void SemanticAnalyzer::analyzeVarDecl(const std::shared_ptr<ASTNode>& node) {
-    if (node->type != NodeType::VarDecl) return;
+void SemanticAnalyzer::analyzeVarDecl(ASTRef node) {
+    if (node.type() != NodeType::VarDecl) return;
 
-    std::string varName = node->value;
-    std::string varType = node->typeHint;
+    Name varName = node.value();
+    Name varType = node.typeHint();
 
     // Check for initialization
-    if (!node->children.empty()) {
-        std::string initValue = node->children[0]->value;
-        symbolTable.declareWithInit(varName, varType, initValue, node->line);
+    if (node.hasChildren()) {
+        std::string initValue = node.child(0).value().str();
+        symbolTable.declareWithInit(varName, varType, initValue, node.line());
         
         // Generate TAC for initialization
-        std::string temp = generateExpressionTAC(node->children[0]);
-        tacInstructions.emplace_back("", "STORE", temp, "", varName, node->line);
+        Name temp = generateExpressionTAC(node.child(0));
+        tacInstructions.emplace_back("", "STORE", temp, "", varName, node.line());
     } else {
-        symbolTable.declare(varName, varType, "", node->line);
+        symbolTable.declare(varName, varType, "", node.line());
     }
 }
 
-void SemanticAnalyzer::analyzeCompoundAssign(const std::shared_ptr<ASTNode>& node) {
-    if (node->type != NodeType::CompoundAssign) return;
+void SemanticAnalyzer::analyzeCompoundAssign(ASTRef node) {
+    if (node.type() != NodeType::CompoundAssign) return;
 
-    std::string var = node->value;
-    const Symbol* symbol = symbolTable.lookup(var, node->line);
+    Name var = node.value();
+    const Symbol* symbol = symbolTable.lookup(var, node.line());
     
     if (!symbol) {
-        symbolTable.addWarning("Use of undeclared variable in compound assignment", node->line);
+        symbolTable.addWarning("Use of undeclared variable in compound assignment", node.line());
         return;
     }
 
@@ -1212,22 +1353,22 @@ void SemanticAnalyzer::analyzeCompoundAssign(const std::shared_ptr<ASTNode>& nod
     generateCompoundAssignTAC(node);
 }
 
-void SemanticAnalyzer::generateCompoundAssignTAC(const std::shared_ptr<ASTNode>& node) {
-    if (!node || node->type != NodeType::CompoundAssign) return;
+void SemanticAnalyzer::generateCompoundAssignTAC(ASTRef node) {
+    if (!node || node.type() != NodeType::CompoundAssign) return;
 
-    std::string var = node->value;
-    std::string op = node->typeHint;  // Assuming typeHint stores the operator type (+=, -=, etc.)
+    Name var = node.value();
+    Name op = node.typeHint();  // Assuming typeHint stores the operator type (+=, -=, etc.)
     
     // Generate TAC for the right-hand side expression
-    std::string rhs = generateExpressionTAC(node->children[0]);
+    Name rhs = generateExpressionTAC(node.child(0));
     
     // Load the current value of the variable
-    std::string temp1 = newTemp();
-    tacInstructions.emplace_back("", "LOAD", var, "", temp1, node->line);
+    Name temp1 = newTemp();
+    tacInstructions.emplace_back("", "LOAD", var, "", temp1, node.line());
     
     // Perform the operation
-    std::string temp2 = newTemp();
-    std::string tacOp;
+    Name temp2 = newTemp();
+    Name tacOp;
     
     if (op == "+=") tacOp = "ADD";
     else if (op == "-=") tacOp = "SUB";
@@ -1239,8 +1380,8 @@ void SemanticAnalyzer::generateCompoundAssignTAC(const std::shared_ptr<ASTNode>&
         return;
     }
     
-    tacInstructions.emplace_back("", tacOp, temp1, rhs, temp2, node->line);
+    tacInstructions.emplace_back("", tacOp, temp1, rhs, temp2, node.line());
     
     // Store the result back in the variable
-    tacInstructions.emplace_back("", "STORE", temp2, "", var, node->line);
+    tacInstructions.emplace_back("", "STORE", temp2, "", var, node.line());
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "../include/StringPool.h"
+#include <cstring>
+#include <iomanip>
+
+namespace {
+thread_local StringPool* activePool = nullptr;
+}
+
+std::string_view StringPool::store(std::string_view text) {
+    size_t needed = text.size() + 1; // Keep a NUL after each spelling for C APIs
+    char* copy;
+    if (needed > kChunkSize / 4) {
+        // Oversized spellings get a block of their own so the current chunk is not abandoned
+        oversized.emplace_back(new char[needed]);
+        counters.arenaBytes += needed;
+        copy = oversized.back().get();
+    } else {
+        if (needed > remaining) {
+            chunks.emplace_back(new char[kChunkSize]);
+            counters.arenaBytes += kChunkSize;
+            cursor = chunks.back().get();
+            remaining = kChunkSize;
+        }
+        copy = cursor;
+        cursor += needed;
+        remaining -= needed;
+    }
+    std::memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    return std::string_view(copy, text.size());
+}
+
+uint32_t StringPool::add(std::string_view text) {
+    uint32_t id = static_cast<uint32_t>(spellings.size());
+    spellings.push_back(text);
+    ids.emplace(text, id);
+    return id;
+}
+
+uint32_t StringPool::intern(std::string_view text) {
+    counters.lookups++;
+    counters.bytesRequested += text.size();
+    if (text.empty()) {
+        counters.hits++;
+        return kEmptyId;
+    }
+    auto it = ids.find(text);
+    if (it != ids.end()) {
+        counters.hits++;
+        return it->second;
+    }
+    counters.bytesStored += text.size();
+    return add(store(text));
+}
+
+uint32_t StringPool::intern_borrowed(std::string_view text) {
+    counters.lookups++;
+    counters.bytesRequested += text.size();
+    if (text.empty()) {
+        counters.hits++;
+        return kEmptyId;
+    }
+    auto it = ids.find(text);
+    if (it != ids.end()) {
+        counters.hits++;
+        return it->second;
+    }
+    counters.bytesBorrowed += text.size();
+    return add(text);
+}
+
+void StringPool::clear() {
+    ids.clear();
+    spellings.clear();
+    oversized.clear();
+    // Keep one chunk around; a fresh compilation usually needs it straight away
+    if (chunks.size() > 1) {
+        chunks.erase(chunks.begin() + 1, chunks.end());
+    }
+    cursor = chunks.empty() ? nullptr : chunks.front().get();
+    remaining = chunks.empty() ? 0 : kChunkSize;
+    counters = StringPoolStats();
+    counters.arenaBytes = chunks.size() * kChunkSize;
+}
+
+void StringPool::printStats(std::ostream& os) const {
+    double hitRate = counters.lookups ? 100.0 * counters.hits / counters.lookups : 0.0;
+    os << "String pool statistics\n";
+    os << std::string(40, '-') << "\n";
+    os << std::left << std::setw(24) << "Intern calls" << counters.lookups << "\n";
+    os << std::left << std::setw(24) << "Hits" << counters.hits
+       << " (" << std::fixed << std::setprecision(1) << hitRate << "%)\n";
+    os << std::left << std::setw(24) << "Distinct names" << spellings.size() << "\n";
+    os << std::left << std::setw(24) << "Bytes requested" << counters.bytesRequested << "\n";
+    os << std::left << std::setw(24) << "Bytes stored" << counters.bytesStored << "\n";
+    os << std::left << std::setw(24) << "Bytes borrowed" << counters.bytesBorrowed << "\n";
+    os << std::left << std::setw(24) << "Arena reserved" << counters.arenaBytes << "\n";
+    os << std::string(40, '-') << "\n";
+}
+
+StringPool& StringPool::current() {
+    if (activePool == nullptr) {
+        // Code that runs outside a compilation (tools, benchmarks) gets a per-thread pool
+        thread_local StringPool fallback;
+        return fallback;
+    }
+    return *activePool;
+}
+
+StringPool::Scope::Scope(StringPool& pool) : previous(activePool) {
+    activePool = &pool;
+}
+
+StringPool::Scope::~Scope() {
+    activePool = previous;
+}
@@ -4,13 +4,35 @@
 #include <ctime>
 #include <cstring>
 
+namespace {
+// Reports list symbols alphabetically; the hash maps themselves are unordered
+std::vector<const SymbolMap::value_type*> sortedByName(const SymbolMap& symbols) {
+    std::vector<const SymbolMap::value_type*> entries;
+    entries.reserve(symbols.size());
+    for (const auto& entry : symbols) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) {
+        return a->first.view() < b->first.view();
+    });
+    return entries;
+}
+
+constexpr size_t kFirstSlots = 64;
+
+// Fibonacci hashing: ids are dense, so spread them over the table's high bits
+size_t slotIndex(uint32_t id, size_t mask) {
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+}
+
 Symbol::Symbol() : initialized(false), used(false), line(0), isFunction(false) {}
 
-Symbol::Symbol(const std::string& t, const std::string& s, const std::string& a, int l)
+Symbol::Symbol(Name t, Name s, const std::string& a, int l)
     : type(t), scope(s), attributes(a), initialized(false), used(false), line(l), isFunction(false) {}
 
-Symbol::Symbol(const std::string& t, const std::string& s, const std::string& a, int l,
-               const std::vector<std::string>& params, const std::string& ret)
+Symbol::Symbol(Name t, Name s, const std::string& a, int l,
+               const std::vector<Name>& params, Name ret)
     : type(t), scope(s), attributes(a), initialized(false), used(false), line(l),
       paramTypes(params), returnType(ret), isFunction(true) {}
 
@@ -23,41 +45,121 @@ ScopeCheck::ScopeCheck(const std::string& s, const std::string& a, int count)
 SemanticIssue::SemanticIssue(const std::string& t, const std::string& desc, const std::string& stat)
     : type(t), description(desc), status(stat) {}
 
-SymbolTable::SymbolTable() : hasStdioInclude(false) {
-    scopes.emplace_back(); // Global scope
+SymbolTable::SymbolTable() : slots(kFirstSlots), slotsInUse(0), hasStdioInclude(false) {
+    scopeStarts.push_back(0); // Global scope
     scopeNames.push_back("global");
 }
 
-void SymbolTable::enterScope(const std::string& scopeName) {
-    scopes.emplace_back();
+const SymbolTable::NameSlot* SymbolTable::find(Name name) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = slotIndex(name.id(), mask);; i = (i + 1) & mask) {
+        const NameSlot& slot = slots[i];
+        if (slot.name == name.id()) {
+            return &slot;
+        }
+        if (slot.name == kFreeSlot) {
+            return nullptr;
+        }
+    }
+}
+
+SymbolTable::NameSlot* SymbolTable::find(Name name) {
+    return const_cast<NameSlot*>(static_cast<const SymbolTable*>(this)->find(name));
+}
+
+// Slots are never emptied: a name whose variables have all gone out of scope keeps its slot
+// for the next declaration, so probes need no tombstones
+SymbolTable::NameSlot& SymbolTable::slotFor(Name name) {
+    if ((slotsInUse + 1) * 2 > slots.size()) {
+        grow();
+    }
+    size_t mask = slots.size() - 1;
+    size_t i = slotIndex(name.id(), mask);
+    while (slots[i].name != name.id() && slots[i].name != kFreeSlot) {
+        i = (i + 1) & mask;
+    }
+    if (slots[i].name == kFreeSlot) {
+        slots[i].name = name.id();
+        slotsInUse++;
+    }
+    return slots[i];
+}
+
+void SymbolTable::grow() {
+    std::vector<NameSlot> old(slots.size() * 2);
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const NameSlot& slot : old) {
+        if (slot.name == kFreeSlot) {
+            continue;
+        }
+        size_t i = slotIndex(slot.name, mask);
+        while (slots[i].name != kFreeSlot) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+}
+
+std::vector<const ScopedSymbol*> SymbolTable::scopeSymbols(size_t index) const {
+    size_t end = index + 1 < scopeStarts.size() ? scopeStarts[index + 1] : declared.size();
+    std::vector<const ScopedSymbol*> entries;
+    entries.reserve(end - scopeStarts[index]);
+    for (size_t i = scopeStarts[index]; i < end; ++i) {
+        entries.push_back(&declared[i]);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) {
+        return a->name.view() < b->name.view();
+    });
+    return entries;
+}
+
+bool SymbolTable::declaredInCurrentScope(Name name) const {
+    const NameSlot* slot = find(name);
+    return slot && slot->innermost != kNoEntry && slot->innermost >= scopeStarts.back();
+}
+
+void SymbolTable::push(Name name, const Symbol& symbol) {
+    NameSlot& slot = slotFor(name);
+    declared.push_back(ScopedSymbol{name, slot.innermost, symbol});
+    slot.innermost = static_cast<uint32_t>(declared.size() - 1);
+}
+
+void SymbolTable::enterScope(Name scopeName) {
+    scopeStarts.push_back(declared.size());
     scopeNames.push_back(scopeName);
-    scopeChecks.emplace_back(scopeName, "Entered", 0);
+    scopeChecks.emplace_back(scopeName.str(), "Entered", 0);
 }
 
 void SymbolTable::exitScope() {
-    if (scopes.size() > 1) {
-        int symbolCount = scopes.back().size();
-        scopeChecks.emplace_back(scopeNames.back(), "Exited", symbolCount);
-        scopes.pop_back();
+    if (scopeStarts.size() > 1) {
+        int symbolCount = declared.size() - scopeStarts.back();
+        scopeChecks.emplace_back(scopeNames.back().str(), "Exited", symbolCount);
+        while (declared.size() > scopeStarts.back()) {
+            const ScopedSymbol& last = declared.back();
+            find(last.name)->innermost = last.shadowed;
+            declared.pop_back();
+        }
+        scopeStarts.pop_back();
         scopeNames.pop_back();
     }
 }
 
-bool SymbolTable::declare(const std::string& name, const std::string& type, const std::string& attributes, int line) {
-    if (scopes.back().find(name) != scopes.back().end()) {
+bool SymbolTable::declare(Name name, Name type, const std::string& attributes, int line) {
+    if (declaredInCurrentScope(name)) {
         issues.emplace_back("Error", "Redeclaration of '" + name + "' in scope '" + scopeNames.back() + "' at line " + std::to_string(line), "❌");
         return false;
     }
     
     Symbol symbol(type, scopeNames.back(), attributes, line);
-    scopes.back()[name] = symbol;
+    push(name, symbol);
     
-    addTypeCheck(name, "Variable declaration of type " + type, "OK");
+    addTypeCheck(name.str(), "Variable declaration of type " + type, "OK");
     return true;
 }
 
-bool SymbolTable::declareWithInit(const std::string& name, const std::string& type, const std::string& value, int line) {
-    if (scopes.back().find(name) != scopes.back().end()) {
+bool SymbolTable::declareWithInit(Name name, Name type, const std::string& value, int line) {
+    if (declaredInCurrentScope(name)) {
         issues.emplace_back("Error", "Redeclaration of '" + name + "' in scope '" + scopeNames.back() + "' at line " + std::to_string(line), "❌");
         return false;
     }
@@ -65,39 +167,41 @@ bool SymbolTable::declareWithInit(const std::string& name, const std::string& ty
     Symbol symbol(type, scopeNames.back(), "variable", line);
     symbol.initialized = true;
     symbol.initialValue = value;
-    scopes.back()[name] = symbol;
+    push(name, symbol);
     
-    addTypeCheck(name, "Variable declaration with initialization of type " + type, "OK");
+    addTypeCheck(name.str(), "Variable declaration with initialization of type " + type, "OK");
     return true;
 }
 
-bool SymbolTable::defineMacro(const std::string& name, const std::string& value, int line) {
+bool SymbolTable::defineMacro(Name name, const std::string& value, int line) {
     if (macros.find(name) != macros.end()) {
         issues.emplace_back("Error", "Redefinition of macro '" + name + "' at line " + std::to_string(line), "❌");
         return false;
     }
-    macros[name] = Symbol("macro", "global", value, line);
+    Symbol& macro = macros[name] = Symbol("macro", "global", value, line);
+    slotFor(name).macro = &macro;
     return true;
 }
 
-bool SymbolTable::defineStruct(const std::string& name, int line) {
+bool SymbolTable::defineStruct(Name name, int line) {
     if (structs.find(name) != structs.end()) {
         issues.emplace_back("Error", "Redefinition of struct '" + name + "' at line " + std::to_string(line), "❌");
         return false;
     }
-    structs[name] = Symbol("struct", "global", "", line);
+    Symbol& structure = structs[name] = Symbol("struct", "global", "", line);
+    slotFor(name).structure = &structure;
     return true;
 }
 
-bool SymbolTable::defineFunction(const std::string& name, const std::string& type,
-                               const std::vector<std::string>& params, int line) {
+bool SymbolTable::defineFunction(Name name, Name type,
+                               const std::vector<Name>& params, int line) {
     if (functions.find(name) != functions.end()) {
         addWarning("Redefinition of function '" + name + "'", line);
         return false;
     }
 
     Symbol symbol(type, "global", "function", line, params, type);
-    functions[name] = symbol;
+    slotFor(name).function = &(functions[name] = symbol);
 
     // Create scope for function parameters
     enterScope(name);
@@ -107,62 +211,40 @@ bool SymbolTable::defineFunction(const std::string& name, const std::string& typ
         }
     }
 
-    addTypeCheck(name, "Function definition with return type " + type, "OK");
+    addTypeCheck(name.str(), "Function definition with return type " + type, "OK");
     return true;
 }
 
-const Symbol* SymbolTable::lookup(const std::string& name, int line) const {
-    // Check current scope and outer scopes
-    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
-        auto it = scope->find(name);
-        if (it != scope->end()) {
-            return &(it->second);
-        }
+const Symbol* SymbolTable::lookup(Name name, int line) const {
+    const NameSlot* slot = find(name);
+    if (!slot) {
+        return nullptr;
     }
-    
-    // Check functions
-    auto funcIt = functions.find(name);
-    if (funcIt != functions.end()) {
-        return &(funcIt->second);
+    // Variables shadow functions, which shadow macros, which shadow structs
+    if (slot->innermost != kNoEntry) {
+        return &declared[slot->innermost].symbol;
     }
-    
-    // Check macros
-    auto macroIt = macros.find(name);
-    if (macroIt != macros.end()) {
-        return &(macroIt->second);
+    if (slot->function) {
+        return slot->function;
     }
-    
-    // Check structs
-    auto structIt = structs.find(name);
-    if (structIt != structs.end()) {
-        return &(structIt->second);
+    if (slot->macro) {
+        return slot->macro;
     }
-    
-    return nullptr;
+    return slot->structure;
 }
 
-void SymbolTable::markUsed(const std::string& name) {
-    // Check scopes
-    for (auto& scope : scopes) {
-        auto it = scope.find(name);
-        if (it != scope.end()) {
-            it->second.used = true;
-            return;
-        }
-    }
-    
-    // Check functions
-    auto funcIt = functions.find(name);
-    if (funcIt != functions.end()) {
-        funcIt->second.used = true;
+// Marks the declaration a lookup would find, so a shadowed outer variable stays unused
+void SymbolTable::markUsed(Name name) {
+    NameSlot* slot = find(name);
+    if (!slot) {
         return;
     }
-    
-    // Check macros
-    auto macroIt = macros.find(name);
-    if (macroIt != macros.end()) {
-        macroIt->second.used = true;
-        return;
+    if (slot->innermost != kNoEntry) {
+        declared[slot->innermost].symbol.used = true;
+    } else if (slot->function) {
+        slot->function->used = true;
+    } else if (slot->macro) {
+        slot->macro->used = true;
     }
 }
 
@@ -187,8 +269,10 @@ void SymbolTable::addWarning(const std::string& description, int line) {
 
 void SymbolTable::checkUnusedSymbols() {
     // Check variables in all scopes
-    for (size_t i = 0; i < scopes.size(); ++i) {
-        for (const auto& [name, symbol] : scopes[i]) {
+    for (size_t i = 0; i < scopeStarts.size(); ++i) {
+        for (const ScopedSymbol* entry : scopeSymbols(i)) {
+            const Name name = entry->name;
+            const Symbol& symbol = entry->symbol;
             if (!symbol.used) {
                 issues.emplace_back(
                     "Warning",
@@ -201,7 +285,8 @@ void SymbolTable::checkUnusedSymbols() {
     }
 
     // Check functions
-    for (const auto& [name, symbol] : functions) {
+    for (const auto* entry : sortedByName(functions)) {
+        const auto& [name, symbol] = *entry;
         if (!symbol.used && name != "main") {  // Ignore main function
             issues.emplace_back(
                 "Warning",
@@ -212,14 +297,14 @@ void SymbolTable::checkUnusedSymbols() {
     }
 }
 
-void SymbolTable::enterFunction(const std::string& name) {
+void SymbolTable::enterFunction(Name name) {
     currentFunction = name;
     enterScope(name);
 }
 
 void SymbolTable::exitFunction() {
     exitScope();
-    currentFunction.clear();
+    currentFunction = Name();
 }
 
 bool SymbolTable::hasOnlyWarnings() const {
@@ -227,7 +312,7 @@ bool SymbolTable::hasOnlyWarnings() const {
         [](const SemanticIssue& issue) { return issue.type == "Warning"; });
 }
 
-void SymbolTable::validateDeclaration(const std::string& name, const std::string& type, int line) {
+void SymbolTable::validateDeclaration(Name name, Name type, int line) {
     if (type.empty()) {
         issues.emplace_back("Error", "Declaration of '" + name + "' has no type at line " + std::to_string(line), "❌");
     }
@@ -255,12 +340,16 @@ void SymbolTable::printSymbolTable() const {
     std::cout << "╠═════════════════════╪══════════════════════╪═══════════════╪══════════════════╪════════════╪═══════╪═══════╣\n";
 
     // Print variables from all scopes
-    for (size_t i = 0; i < scopes.size(); ++i) {
-        for (const auto& [name, symbol] : scopes[i]) {
+    for (size_t i = 0; i < scopeStarts.size(); ++i) {
+        for (const ScopedSymbol* entry : scopeSymbols(i)) {
+            const std::string name = entry->name.str();
+            const Symbol& symbol = entry->symbol;
             if (!symbol.isFunction) {  // Only print variables here
+                const std::string type = symbol.type.str();
+                const std::string scope = symbol.scope.str();
                 std::string name_trunc = name.length() > 19 ? name.substr(0, 16) + "..." : name;
-                std::string type_trunc = symbol.type.length() > 19 ? symbol.type.substr(0, 16) + "..." : symbol.type;
-                std::string scope_trunc = symbol.scope.length() > 13 ? symbol.scope.substr(0, 10) + "..." : symbol.scope;
+                std::string type_trunc = type.length() > 19 ? type.substr(0, 16) + "..." : type;
+                std::string scope_trunc = scope.length() > 13 ? scope.substr(0, 10) + "..." : scope;
                 std::string attr_trunc = symbol.attributes.length() > 16 ? symbol.attributes.substr(0, 13) + "..." : symbol.attributes;
                 
                 std::cout << "║ " << std::left << std::setw(20) << name_trunc
@@ -275,12 +364,16 @@ void SymbolTable::printSymbolTable() const {
     }
 
     // Print functions
-    for (const auto& [name, symbol] : functions) {
+    for (const auto* entry : sortedByName(functions)) {
+        const std::string name = entry->first.str();
+        const Symbol& symbol = entry->second;
         if (name == "printf" || name == "scanf") continue;  // Skip standard functions
         
+        const std::string type = symbol.type.str();
+        const std::string scope = symbol.scope.str();
         std::string name_trunc = name.length() > 19 ? name.substr(0, 16) + "..." : name;
-        std::string type_trunc = symbol.type.length() > 19 ? symbol.type.substr(0, 16) + "..." : symbol.type;
-        std::string scope_trunc = symbol.scope.length() > 13 ? symbol.scope.substr(0, 10) + "..." : symbol.scope;
+        std::string type_trunc = type.length() > 19 ? type.substr(0, 16) + "..." : type;
+        std::string scope_trunc = scope.length() > 13 ? scope.substr(0, 10) + "..." : scope;
         std::string attr_trunc = symbol.attributes.length() > 16 ? symbol.attributes.substr(0, 13) + "..." : symbol.attributes;
         
         std::cout << "║ " << std::left << std::setw(20) << name_trunc
@@ -293,9 +386,7 @@ void SymbolTable::printSymbolTable() const {
     }
 
     std::cout << "╚═════════════════════╧══════════════════════╧═══════════════╧══════════════════╧════════════╧═══════╧═══════╝\n";
-    std::cout << "\nTotal Symbols: " << (functions.size() + 
-        std::accumulate(scopes.begin(), scopes.end(), 0, 
-            [](int sum, const auto& scope) { return sum + scope.size(); })) << "\n";
+    std::cout << "\nTotal Symbols: " << (functions.size() + declared.size()) << "\n";
     std::cout << std::string(92, '=') << "\n\n";
 }
 
@@ -4,18 +4,18 @@
 
 TACGenerator::TACGenerator() : tempCounter(0), labelCounter(0) {}
 
-std::string TACGenerator::newTemp() {
+Name TACGenerator::newTemp() {
     return "t" + std::to_string(++tempCounter);
 }
 
-std::string TACGenerator::newLabel() {
+Name TACGenerator::newLabel() {
     return "L" + std::to_string(++labelCounter);
 }
 
-void TACGenerator::addInstruction(std::string op, std::string arg1, std::string arg2, 
-                                std::string result, int line, std::string comment) {
+void TACGenerator::addInstruction(Name op, Name arg1, Name arg2, 
+                                Name result, int line, std::string comment) {
     // Create instruction with empty label by default
-    instructions.emplace_back("", op, arg1, arg2, result, line, comment);
+    instructions.emplace_back(Name(), op, arg1, arg2, result, line, comment);
 }
 
 const std::vector<TACInstruction>& TACGenerator::getInstructions() const {
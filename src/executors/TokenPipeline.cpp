@@ -0,0 +1,75 @@
+#include "../include/TokenPipeline.h"
+#include "../include/lexer_utils.hpp"
+#include "../include/trace.hpp"
+
+namespace {
+
+// Spins briefly on a ring that is momentarily full or empty, then lets the other thread run
+constexpr unsigned kSpinsBeforeYield = 64;
+
+void backOff(unsigned& spins) {
+    if (++spins >= kSpinsBeforeYield) {
+        std::this_thread::yield();
+    }
+}
+
+}
+
+TokenPipeline::TokenPipeline(FrontendContext& context) : ctx(context), stream(context) {}
+
+bool TokenPipeline::open(const char* filename) {
+    close();
+    if (!stream.open(filename)) {
+        return false;
+    }
+    finished.store(false, std::memory_order_relaxed);
+    stopping.store(false, std::memory_order_relaxed);
+    producerWaits = 0;
+    consumerWaits = 0;
+    lexer = std::thread(&TokenPipeline::produce, this);
+    return true;
+}
+
+void TokenPipeline::close() {
+    if (!lexer.joinable()) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    lexer.join();
+    stream.close();
+    UC_TRACE(TraceLevel::Info, TraceCategory::Lexer, "Pipeline: lexer waited " << producerWaits
+             << " times on a full ring, parser " << consumerWaits << " times on an empty one");
+}
+
+void TokenPipeline::produce() {
+    while (const Tokens* token = stream.next()) {
+        PipelinedToken item;
+        item.token = *token;
+        item.text = ctx.strings.view(token->lexeme);
+        if (token->kind == TokenKind::Unknown) {
+            item.line = ctx.position(token->file, token->offset).line;
+        }
+        unsigned spins = 0;
+        while (!ring.tryPush(item)) {
+            if (stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+            producerWaits++;
+            backOff(spins);
+        }
+    }
+    finished.store(true, std::memory_order_release);
+}
+
+const PipelinedToken* TokenPipeline::next() {
+    unsigned spins = 0;
+    while (!ring.tryPop(current)) {
+        // Everything pushed before finished was set is visible once it reads true
+        if (finished.load(std::memory_order_acquire)) {
+            return ring.tryPop(current) ? &current : nullptr;
+        }
+        consumerWaits++;
+        backOff(spins);
+    }
+    return &current;
+}
@@ -5,88 +5,251 @@
 #include <sstream>
 #include "../include/lexer_utils.hpp"
 #include "../include/lexer.h"
+#include "../include/ParallelLexer.h"
+#include "../include/PreludeSnapshot.h"
 
-// Define line_num
-int line_num = 1;
+// Reset ctx for a new file and point a fresh scanner at it (mapped in place, or through stdio)
+static bool startScanner(FrontendContext& ctx, const char* filename, yyscan_t& scanner, FILE*& input) {
+    // Drop the old lexemes before the buffer they may point into
+    ctx.tokens.clear();
+    ctx.unknown_tokens.clear();
+    ctx.strings.clear();
+    seed_reserved_lexemes(ctx.strings);
+    ctx.source.close();
+    ctx.snapshot.close();
+    ctx.source_path = filename;
+    ctx.lines.clear();
+    ctx.include_sources.clear();
+    ctx.include_guards.clear();
+    ctx.conditions.clear();
+    ctx.scan_offset = 0;
+    ctx.scan_hazard = false;
+    ctx.tokens_ready = false;
 
-void performLexicalAnalysis(const char* filename) {    
-    // Ensure ../temp/ directory exists
-    std::filesystem::create_directories("../temp");
-    
-    yyin = fopen(filename, "r");
-    if (!yyin) {
-        std::cerr << "Error: Could not open input file: " << filename << "\n";
-        return;
+    input = nullptr;
+    if (ctx.map_source && ctx.source.open(filename)) {
+        ctx.source_in_memory = true;
+    } else {
+        input = fopen(filename, "r");
+        if (!input) {
+            std::cerr << "Error: Could not open input file: " << filename << "\n";
+            return false;
+        }
     }
 
-    while (yylex() != 0) {} // Loop until EOF
-    fclose(yyin);
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Error: Could not initialise the scanner\n";
+        if (input) fclose(input);
+        ctx.source_in_memory = false;
+        return false;
+    }
+    if (ctx.source_in_memory) {
+        // Scan the buffer in place: no stdio staging and no refills, yytext points into the file
+        yy_scan_buffer(ctx.source.data(), ctx.source.paddedSize(), scanner);
+    } else {
+        yyset_in(input, scanner);
+    }
+    return true;
+}
 
-    // Check for unknown tokens
-    if (!unknown_tokens.empty()) {
-        for (const auto& token : unknown_tokens) {
-            std::cerr << "Error: Unknown tokens detected.";
-        }        
-        return;
+// The mapped source stays open: pooled lexemes may still borrow from it
+static void stopScanner(FrontendContext& ctx, yyscan_t scanner, FILE* input) {
+    yylex_destroy(scanner);
+    if (input) fclose(input);
+    ctx.source_in_memory = false;
+}
+
+// Run the scanner over filename, leaving the result in ctx.tokens/ctx.unknown_tokens
+bool lexSourceFile(FrontendContext& ctx, const char* filename) {
+    // A snapshot assumes the scan starts with no macros defined
+    bool usePrelude = !ctx.pch_path.empty() && ctx.macros.empty() && ctx.expand_macros && ctx.expand_includes;
+    yyscan_t scanner;
+    FILE* input;
+    if (!startScanner(ctx, filename, scanner, input)) {
+        return false;
+    }
+    uint32_t resume = 0;
+    bool resumed = usePrelude && ctx.source_in_memory && loadPreludeSnapshot(ctx, resume);
+    if (resumed) {
+        // Scan only what follows the prelude, on a scanner started there
+        yylex_destroy(scanner);
+        if (yylex_init_extra(&ctx, &scanner) != 0) {
+            std::cerr << "Error: Could not initialise the scanner\n";
+            ctx.source_in_memory = false;
+            return false;
+        }
+        yy_scan_buffer(ctx.source.data() + resume, ctx.source.paddedSize() - resume, scanner);
+        ctx.scan_offset = resume;
+        while (yylex(scanner) != ScanEnd) {}
+    } else if (!lexSourceInParallel(ctx)) {
+        // A large mapped file is split across threads; otherwise scan it here
+        while (yylex(scanner) != ScanEnd) {} // Loop until EOF
+    }
+    stopScanner(ctx, scanner, input);
+    if (usePrelude && !resumed && ctx.source.isOpen()) {
+        savePreludeSnapshot(ctx);
+    }
+
+    ctx.tokens_ready = true;
+    return true;
+}
+
+bool TokenStream::open(const char* filename) {
+    close();
+    if (!startScanner(ctx, filename, scanner, input)) {
+        scanner = nullptr;
+        input = nullptr;
+        return false;
     }
+    ctx.token_ring.clear();
+    ctx.token_stream = this;
+    exhausted = false;
+    return true;
+}
 
-    std::ofstream outfile("../temp/lex-tokens.txt");
-    if (!outfile.is_open()) {
-        std::cerr << "Error: Could not open temp/lex-tokens.txt for writing\n";
+void TokenStream::close() {
+    if (scanner == nullptr) {
         return;
     }
+    stopScanner(ctx, scanner, input);
+    scanner = nullptr;
+    input = nullptr;
+    ctx.token_ring.clear();
+    ctx.token_stream = nullptr;
+}
 
-    // Write enhanced tabular format
-    outfile << "+----------------------+----------------------------------------+--------+--------+\n";
-    outfile << "| Token Type           | Value                                  | Line   | Col    |\n";
-    outfile << "+----------------------+----------------------------------------+--------+--------+\n";
-    for (const auto& token : tokens) {
-        std::string escaped_value = token.value;
+const Tokens* TokenStream::next() {
+    while (ctx.token_ring.empty()) {
+        if (exhausted || scanner == nullptr) {
+            return nullptr;
+        }
+        // yylex() returns early each time the ring fills and 0 once the input is used up
+        if (yylex(scanner) == ScanEnd) {
+            exhausted = true;
+        }
+    }
+    current = ctx.token_ring.pop();
+    return &current;
+}
+
+static const char* const kTokenTableRule =
+    "+----------------------+----------------------------------------+--------+--------+\n";
+
+static void writeTokenTableHeader(std::ostream& os) {
+    os << kTokenTableRule;
+    os << "| Token Type           | Value                                  | Line   | Col    |\n";
+    os << kTokenTableRule;
+}
+
+// The file variant escapes tabs/newlines, the console variant spells newlines out
+static void writeTokenTableRow(const FrontendContext& ctx, const Tokens& token, std::ostream& os, bool for_file) {
+    SourcePosition position = ctx.position(token.file, token.offset);
+    std::string display_value(ctx.strings.view(token.lexeme));
+    size_t pos = 0;
+    if (for_file) {
         // Escape special characters
-        size_t pos = 0;
-        while ((pos = escaped_value.find("\t", pos)) != std::string::npos) {
-            escaped_value.replace(pos, 1, "\\t");
+        while ((pos = display_value.find("\t", pos)) != std::string::npos) {
+            display_value.replace(pos, 1, "\\t");
             pos += 2;
         }
         pos = 0;
-        while ((pos = escaped_value.find("\n", pos)) != std::string::npos) {
-            escaped_value.replace(pos, 1, "\\n");
+        while ((pos = display_value.find("\n", pos)) != std::string::npos) {
+            display_value.replace(pos, 1, "\\n");
             pos += 2;
         }
-        // Truncate value if too long
-        if (escaped_value.length() > 36) {
-            escaped_value = escaped_value.substr(0, 33) + "...";
-        }
-        outfile << "| " << std::left << std::setw(20) << token.type 
-                << " | " << std::left << std::setw(38) << escaped_value 
-                << " | " << std::right << std::setw(6) << token.line_no 
-                << " | " << std::right << std::setw(6) << token.col_no 
-                << " |\n";
-    }
-    outfile << "+----------------------+----------------------------------------+--------+--------+\n";
-    outfile.close();
-
-    // Print only tabular output to terminal
-    std::cout << "+----------------------+----------------------------------------+--------+--------+\n";
-    std::cout << "| Token Type           | Value                                  | Line   | Col    |\n";
-    std::cout << "+----------------------+----------------------------------------+--------+--------+\n";
-    for (const auto& token : tokens) {
-        std::string display_value = token.value;
+    } else {
         // Replace newlines with descriptive text for display
-        size_t pos = 0;
         while ((pos = display_value.find("\n", pos)) != std::string::npos) {
             display_value.replace(pos, 1, "(newline)");
             pos += 9;
         }
-        // Truncate value for display
-        if (display_value.length() > 36) {
-            display_value = display_value.substr(0, 33) + "...";
+    }
+    // Truncate value if too long
+    if (display_value.length() > 36) {
+        display_value = display_value.substr(0, 33) + "...";
+    }
+    os << "| " << std::left << std::setw(20) << token_kind_name(token.kind)
+       << " | " << std::left << std::setw(38) << display_value
+       << " | " << std::right << std::setw(6) << position.line
+       << " | " << std::right << std::setw(6) << position.column
+       << " |\n";
+}
+
+// Render the token table from ctx.tokens
+void writeTokenTable(const FrontendContext& ctx, std::ostream& os, bool for_file) {
+    writeTokenTableHeader(os);
+    for (const auto& token : ctx.tokens) {
+        writeTokenTableRow(ctx, token, os, for_file);
+    }
+    os << kTokenTableRule;
+}
+
+std::string formatTokenTable(const FrontendContext& ctx) {
+    std::ostringstream table;
+    writeTokenTable(ctx, table, false);
+    return table.str();
+}
+
+// --stream: each row is written as soon as the scanner produces its token, so only the ring's
+// worth of tokens is ever held; unknown tokens are reported where they occur
+static void streamLexicalAnalysis(FrontendContext& ctx, const char* filename, bool dump_tokens) {
+    TokenStream stream(ctx);
+    if (!stream.open(filename)) {
+        return;
+    }
+
+    std::ofstream outfile;
+    if (dump_tokens) {
+        std::filesystem::create_directories("../temp");
+        outfile.open("../temp/lex-tokens.txt");
+        if (!outfile.is_open()) {
+            std::cerr << "Error: Could not open temp/lex-tokens.txt for writing\n";
         }
-        std::cout << "| " << std::left << std::setw(20) << token.type 
-                  << " | " << std::left << std::setw(38) << display_value 
-                  << " | " << std::right << std::setw(6) << token.line_no 
-                  << " | " << std::right << std::setw(6) << token.col_no 
-                  << " |\n";
     }
-    std::cout << "+----------------------+----------------------------------------+--------+--------+\n";
+
+    writeTokenTableHeader(std::cout);
+    if (outfile.is_open()) writeTokenTableHeader(outfile);
+    while (const Tokens* token = stream.next()) {
+        if (token->kind == TokenKind::Unknown) {
+            std::cerr << "Error: Unknown token '" << ctx.strings.view(token->lexeme) << "' at line " << ctx.position(token->file, token->offset).line << "\n";
+            continue;
+        }
+        writeTokenTableRow(ctx, *token, std::cout, false);
+        if (outfile.is_open()) writeTokenTableRow(ctx, *token, outfile, true);
+    }
+    std::cout << kTokenTableRule;
+    if (outfile.is_open()) outfile << kTokenTableRule;
+}
+
+void performLexicalAnalysis(FrontendContext& ctx, const char* filename, bool dump_tokens) {
+    if (ctx.stream_tokens) {
+        streamLexicalAnalysis(ctx, filename, dump_tokens);
+        return;
+    }
+    if (!lexSourceFile(ctx, filename)) {
+        return;
+    }
+
+    // Check for unknown tokens
+    if (!ctx.unknown_tokens.empty()) {
+        for (const auto& token : ctx.unknown_tokens) {
+            std::cerr << "Error: Unknown token '" << ctx.strings.view(token.lexeme) << "' at line " << ctx.position(token.file, token.offset).line << "\n";
+        }
+        return;
+    }
+
+    // The on-disk table is a debug artifact only; the parser consumes tokens in memory
+    if (dump_tokens) {
+        // Ensure ../temp/ directory exists
+        std::filesystem::create_directories("../temp");
+        std::ofstream outfile("../temp/lex-tokens.txt");
+        if (!outfile.is_open()) {
+            std::cerr << "Error: Could not open temp/lex-tokens.txt for writing\n";
+        } else {
+            writeTokenTable(ctx, outfile, true);
+        }
+    }
+
+    // Print only tabular output to terminal
+    writeTokenTable(ctx, std::cout, false);
 }
\ No newline at end of file
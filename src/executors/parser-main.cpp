@@ -3,114 +3,91 @@
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <memory>
 #include "../include/lexer_utils.hpp"
 #include "../include/parser_utils.hpp"
 #include "../include/lexer.h"
+#include "../include/TokenPipeline.h"
+#include "../include/trace.hpp"
 
+extern bool lexSourceFile(FrontendContext& ctx, const char* filename);
 
-ProgramNode* parse_result = nullptr;
-TokenIterator* token_iterator = nullptr;
-
-void performParsing() {
-    // Clear existing tokens
-    tokens.clear();
-    unknown_tokens.clear();
-
-    // Read lex-tokens.txt
-    std::ifstream infile("../temp/lex-tokens.txt");
-    if (!infile.is_open()) {
-        std::cerr << "Error: Could not open temp/lex-tokens.txt for reading\n";
-        return;
+// The text dump of ctx.parse_result, written on first use and then shared by the file, the console
+// and --help
+const std::string& formatParseTree(FrontendContext& ctx) {
+    if (ctx.parse_result != nullptr && ctx.parse_tree_text.empty()) {
+        write_parse_tree(ctx.parse_tree_text, *ctx.parse_result);
     }
+    return ctx.parse_tree_text;
+}
 
-    std::string line;
-    bool header_processed = false;
-    while (std::getline(infile, line)) {
-        line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-
-        if (line.empty()) continue;
-
-        // Skip header and border lines
-        if (!header_processed) {
-            if (line.find("Token Type           | Value") != std::string::npos ||
-                line.find("+----------------------+----------------------------------------+--------+--------+") != std::string::npos) {
-                continue;
-            }
-            header_processed = true;
+// Parses filename into ctx.parse_result (left there for the later stages); false when it fails
+bool parseSource(FrontendContext& ctx, const char* filename) {
+    ctx.parse_result = nullptr;
+    ctx.parse_tree_text.clear();
+    ctx.parse_arena.release(); // The previous tree, all at once
+    TokenStream stream(ctx);
+    std::unique_ptr<TokenPipeline> pipeline;
+    if (ctx.pipeline_tokens && !ctx.tokens_ready) {
+        // --pipeline: the scanner runs ahead on its own thread while the parser consumes
+        pipeline = std::make_unique<TokenPipeline>(ctx);
+        if (!pipeline->open(filename)) {
+            return false;
         }
-
-        // Parse tabular line: | Token Type | Value | Line | Col |
-        // Remove leading/trailing | and split
-        if (line.front() == '|' && line.back() == '|') {
-            line = line.substr(1, line.length() - 2);
+    } else if (ctx.stream_tokens) {
+        // --stream: the parser pulls tokens from the scanner as it needs them
+        if (!stream.open(filename)) {
+            return false;
         }
-        std::stringstream ss(line);
-        std::string type, value, line_no, col_no;
-        std::getline(ss, type, '|');
-        std::getline(ss, value, '|');
-        std::getline(ss, line_no, '|');
-        std::getline(ss, col_no, '|');
-
-        // Trim whitespace
-        type.erase(0, type.find_first_not_of(" \t"));
-        type.erase(type.find_last_not_of(" \t") + 1);
-        value.erase(0, value.find_first_not_of(" \t"));
-        value.erase(value.find_last_not_of(" \t") + 1);
-        line_no.erase(0, line_no.find_first_not_of(" \t"));
-        line_no.erase(line_no.find_last_not_of(" \t") + 1);
-        col_no.erase(0, col_no.find_first_not_of(" \t"));
-        col_no.erase(col_no.find_last_not_of(" \t") + 1);
-
-        // Unescape tabs and newlines in value
-        std::string unescaped_value;
-        bool escape = false;
-        for (char c : value) {
-            if (escape) {
-                if (c == 't') unescaped_value += '\t';
-                else if (c == 'n') unescaped_value += '\n';
-                else unescaped_value += c;
-                escape = false;
-            } else if (c == '\\') {
-                escape = true;
-            } else {
-                unescaped_value += c;
-            }
+    } else {
+        // Reuse the tokens from --lexical in this context, otherwise lex the source now
+        if (!ctx.tokens_ready && !lexSourceFile(ctx, filename)) {
+            return false;
         }
 
-        try {
-            if (type == "Unknown") {
-                unknown_tokens.emplace_back(UnknownTokens{unescaped_value, std::stoi(line_no), std::stoi(col_no)});
-            } else {
-                tokens.emplace_back(Tokens{type, unescaped_value, std::stoi(line_no), std::stoi(col_no)});
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error parsing token: " << line << "\n";
+        // Check for lexing errors
+        if (ctx.tokens.empty() && ctx.unknown_tokens.empty()) {
+            std::cerr << "Error: No valid tokens found.\n";
+            return false;
         }
-    }
-    infile.close();
 
-    // Check for parsing errors
-    if (tokens.empty() && unknown_tokens.empty()) {
-        std::cerr << "Error: No valid tokens found.\n";
-        return;
+        delete ctx.token_iterator;
+        ctx.token_iterator = new TokenIterator(ctx.tokens, ctx.unknown_tokens);
     }
 
     // Run parser
-    token_iterator = new TokenIterator(tokens, unknown_tokens);
-    if (yyparse() == 0 && parse_result != nullptr) {
+    int status = pipeline ? pipelinedParse(&ctx, *pipeline) : yyparse(&ctx);
+    if (pipeline) {
+        pipeline->close(); // ctx is the lexer thread's until it has stopped
+    }
+    delete ctx.token_iterator;
+    ctx.token_iterator = nullptr;
+    if (status != 0) {
+        ctx.parse_result = nullptr;
+    }
+    const ParseArenaStats& arena = ctx.parse_arena.stats();
+    UC_TRACE(TraceLevel::Info, TraceCategory::Parser, "Parse arena: " << arena.nodes << " nodes and lists in "
+             << arena.chunks << " chunks (" << arena.bytes << " bytes)");
+    if (ctx.parse_result == nullptr) {
+        std::cerr << "Error: Parsing failed.";
+        return false;
+    }
+
+    // The text AST is only a dump now; nothing downstream reads it back
+    if (ctx.dump_ast) {
         std::ofstream outfile("../temp/parser-output.ast");
         if (!outfile.is_open()) {
             std::cerr << "Error: Could not open temp/parser-output.ast for writing\n";
-            return;
+        } else {
+            outfile << formatParseTree(ctx);
         }
-        outfile << parse_result->to_string();
-        outfile.close();
-        std::cout << "\nParse Tree:\n" << parse_result->to_string() << "\n";
-    } else {
-        std::cerr << "Error: Parsing failed.";
     }
-    delete token_iterator;
-    delete parse_result;
-    token_iterator = nullptr;
-    parse_result = nullptr;
+    return true;
+}
+
+
+void performParsing(FrontendContext& ctx, const char* filename) {
+    if (parseSource(ctx, filename)) {
+        std::cout << "\nParse Tree:\n" << formatParseTree(ctx) << "\n";
+    }
 }
@@ -1,107 +1,135 @@
 %{
 #include <iostream>
-#include <regex>
 #include <string>
 #include "../include/lexer_utils.hpp"
 #include "../include/parser_utils.hpp"
 #include "../include/lexer.h"
+#include "../include/trace.hpp"
+#include "../include/TokenPipeline.h"
 #include "parser.yy.h"
 
-extern ProgramNode* parse_result;
-extern TokenIterator* token_iterator;
+// The pure parser calls yylex(&yylval, ctx); route that to the in-memory token stream
+#define yylex custom_yylex
 
-#define YYLEX_PARAM token_iterator
-#define yylex() custom_yylex(YYLEX_PARAM)
+// Bison token for each fixed spelling, indexed by lexeme id (the bison column of lexeme_table.hpp)
+#define UC_RESERVED_PARSER_TOKEN(SPELLING, KIND, PARSER_TOKEN) PARSER_TOKEN,
+static constexpr int kReservedParserTokens[] = { UC_RESERVED_LEXEMES(UC_RESERVED_PARSER_TOKEN) };
+#undef UC_RESERVED_PARSER_TOKEN
 
-int custom_yylex(TokenIterator* iter) {
-    if (!iter->has_next()) return 0; // EOF
-    Tokens* token = iter->next();
-    if (token->type == "Unknown") {
-        std::cerr << "Unknown token: " << token->value << " at line " << token->line_no << "\n";
-        return -1; // Error
+// parserToken() result for a token the grammar never sees
+static constexpr int kSkippedToken = -2;
+
+// Bison token for a (known) token whose text is value, with its semantic value stored in lvalp
+static int parserToken(const Tokens* token, std::string_view value, YYSTYPE* lvalp) {
+    UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Processing token: " << token_kind_name(token->kind) << ", Value: " << value);
+    switch (token->kind) {
+        case TokenKind::Keyword:
+        case TokenKind::Punctuation:
+        case TokenKind::Operator:
+        case TokenKind::RelationalOperator:
+            return token->lexeme < kReservedLexemeCount ? kReservedParserTokens[token->lexeme] : -1; // Unparsed keywords/operators map to -1
+        case TokenKind::Identifier:
+            lvalp->text = TokenText{value.data(), static_cast<uint32_t>(value.size())};
+            return IDENTIFIER;
+        case TokenKind::String:
+            lvalp->text = TokenText{value.data(), static_cast<uint32_t>(value.size())};
+            return STRING;
+        case TokenKind::Int:
+        case TokenKind::Float:
+        case TokenKind::Hex:
+        case TokenKind::Octal:
+            lvalp->text = TokenText{value.data(), static_cast<uint32_t>(value.size())};
+            return NUMBER;
+        case TokenKind::MacroExpansion:
+            lvalp->text = TokenText{value.data(), static_cast<uint32_t>(value.size())};
+            return NUMBER; // Treat as NUMBER (e.g., MAX -> 10)
+        case TokenKind::Preprocessor:
+            if (token->flags & TokenFlagInclude) {
+                UC_TRACE(TraceLevel::Info, TraceCategory::Parser, "Skipping #include: " << value);
+                return kSkippedToken;
+            }
+            if (token->flags & TokenFlagConditional) {
+                return kSkippedToken; // Evaluated by the lexer; only the active branch follows
+            }
+            lvalp->text = TokenText{value.data(), static_cast<uint32_t>(value.size())};
+            return PREPROCESSOR;
+        default:
+            return -1; // Fallback
     }
+}
 
-    std::cout << "Processing token: " << token->type << ", Value: " << token->value << "\n"; // Debug
-    if (token->type == "Keyword") {
-        if (token->value == "int") return INT;
-        if (token->value == "return") return RETURN;
-        if (token->value == "float") return FLOAT;
-        if (token->value == "void") return VOID;
-        if (token->value == "if") return IF;
-        if (token->value == "else") return ELSE;
-        if (token->value == "for") return FOR;
-        if (token->value == "while") return WHILE;
-        if (token->value == "struct") return STRUCT;
-        return -1; // Other keywords not parsed yet
-    } else if (token->type == "Identifier") {
-        yylval.str = new std::string(token->value);
-        return IDENTIFIER;
-    } else if (token->type == "Punctuation") {
-        if (token->value == "(") return LPAREN;
-        if (token->value == ")") return RPAREN;
-        if (token->value == "{") return LBRACE;
-        if (token->value == "}") return RBRACE;
-        if (token->value == ";") return SEMICOLON;
-        if (token->value == ",") return COMMA;
-        return -1; // Other punctuation not parsed
-    } else if (token->type == "String") {
-        yylval.str = new std::string(token->value);
-        return STRING;
-    } else if (token->type == "Int" || token->type == "Float" || token->type == "Hex" || token->type == "Octal") {
-        yylval.str = new std::string(token->value);
-        return NUMBER;
-    } else if (token->type == "Macro Expansion") {
-        yylval.str = new std::string(token->value);
-        return NUMBER; // Treat as NUMBER (e.g., MAX -> 10)
-    } else if (token->type == "Preprocessor") {
-        if (std::regex_match(token->value, std::regex("^#include\\s*[<\"][^>\"]+[>\"]\\s*$"))) {
-            std::cout << "Skipping #include: " << token->value << "\n";
-            return custom_yylex(iter); // Skip and get next token
+int custom_yylex(YYSTYPE* lvalp, FrontendContext* ctx) {
+    for (;;) {
+        // Pull straight from the scanner when streaming, otherwise walk the lexed vectors
+        const Tokens* token = ctx->token_stream ? ctx->token_stream->next() : ctx->token_iterator->next();
+        if (token == nullptr) return 0; // EOF
+        std::string_view value = ctx->strings.view(token->lexeme);
+        if (token->kind == TokenKind::Unknown) {
+            std::cerr << "Unknown token: " << value << " at line " << ctx->position(token->file, token->offset).line << "\n";
+            return -1; // Error
+        }
+        int kind = parserToken(token, value, lvalp);
+        if (kind != kSkippedToken) {
+            return kind;
         }
-        yylval.str = new std::string(token->value);
-        return PREPROCESSOR;
-    } else if (token->type == "Operator" || token->type == "Relational Operator") {
-        if (token->value == "=") return ASSIGN;
-        if (token->value == ">") return GT;
-        if (token->value == "<") return LT;
-        if (token->value == "<=") return LE;
-        if (token->value == "==") return EQ;
-        if (token->value == "+") return PLUS;
-        if (token->value == "-") return MINUS;
-        if (token->value == "*") return MULT;
-        if (token->value == "/") return DIV;
-        if (token->value == "%") return MOD;
-        if (token->value == "&") return ADDRESS;
-        if (token->value == "++") return PLUSPLUS;
-        if (token->value == "*=") return MULTEQ;
-        return -1; // Other operators not parsed
     }
-    return -1; // Fallback
 }
 
-void yyerror(const char* msg) {
+void yyerror(FrontendContext* ctx, const char* msg) {
     std::cerr << "Parse error: " << msg << "\n";
 }
 %}
 
+%code requires {
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+class ParseNode;
+class ProgramNode;
+class FunctionNode;
+class StatementNode;
+struct FrontendContext;
+// Value of an IDENTIFIER, NUMBER, STRING or PREPROCESSOR token: a view of its text in the string
+// pool or the mapped source, both of which outlive the parse, so no token allocates or frees
+struct TokenText {
+    const char* data;
+    uint32_t length;
+
+    std::string_view view() const { return std::string_view(data, length); }
+    bool empty() const { return length == 0; }
+    // The text, or fallback for an empty token
+    std::string_view text_or(std::string_view fallback) const { return length != 0 ? view() : fallback; }
+};
+// As in parser_utils.hpp: lists of parse nodes, allocated in the parse arena
+using ExpressionList = std::pmr::vector<ParseNode*>;
+using StatementList = std::pmr::vector<StatementNode*>;
+using FunctionList = std::pmr::vector<FunctionNode*>;
+}
+
+%define api.pure full
+%define api.push-pull both
+%parse-param { FrontendContext* ctx }
+%lex-param { FrontendContext* ctx }
 %define parse.trace
 %verbose
 
 %union {
-    std::string* str;
-    ASTNode* node;
+    TokenText text;
+    ParseNode* node;
     ProgramNode* program;
     FunctionNode* function;
     StatementNode* statement;
-    std::vector<StatementNode*>* decl_list;
-    std::vector<FunctionNode*>* func_list;
-    std::vector<ASTNode*>* expr_list;
+    StatementList* decl_list;
+    FunctionList* func_list;
+    ExpressionList* expr_list;
 }
 
 %token INT RETURN FLOAT VOID IF ELSE FOR WHILE STRUCT ASSIGN MULTEQ LE
 %token GT LT EQ PLUS MINUS MULT DIV MOD ADDRESS PLUSPLUS
 %token COMMA
-%token <str> PREPROCESSOR IDENTIFIER STRING NUMBER
+%token <text> PREPROCESSOR IDENTIFIER STRING NUMBER
 %token LPAREN RPAREN LBRACE RBRACE SEMICOLON
 
 %type <program> program
@@ -123,80 +151,71 @@ void yyerror(const char* msg) {
 program
     : preprocessor_list declaration_list function_list
       { 
-        std::cout << "Building ProgramNode\n"; // Debug
-        $$ = new ProgramNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building ProgramNode");
+        $$ = ctx->parse_arena.make<ProgramNode>(); 
         if ($3 && !$3->empty()) {
-            $$->functions = *$3; // Transfer functions
+            $$->functions = std::move(*$3); // Same arena: the list's storage is taken over
         }
         if ($1 && !$1->children.empty()) {
-            for (const auto* node : $1->children) {
+            for (auto* node : $1->children) {
                 if (node && !node->value.empty()) {
-                    $$->children.push_back(new ASTNode(*node));
+                    $$->children.push_back(node);
                 }
             }
         }
         if ($2 && !$2->empty()) {
             for (const auto* decl : *$2) {
                 if (decl && !decl->value.empty()) {
-                    $$->children.push_back(new ASTNode(decl->type, decl->value));
+                    $$->children.push_back(ctx->parse_arena.make<ParseNode>(decl->type, decl->value));
                 }
             }
         }
-        delete $2; // Delete declaration_list
-        delete $3; // Delete function_list
-        parse_result = $$; 
-        std::cout << "ProgramNode built\n"; // Debug
+        ctx->parse_result = $$; 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "ProgramNode built");
       }
     ;
 
 preprocessor_list
-    : /* empty */ { $$ = new StatementNode(); $$->type = "PreprocessorList"; }
+    : /* empty */ { $$ = ctx->parse_arena.make<StatementNode>(); $$->type = "PreprocessorList"; }
     | preprocessor_list PREPROCESSOR
       { 
-        std::cout << "Building PreprocessorList with: " << ($2 ? *$2 : "null") << "\n"; // Debug
-        $$ = $1 ? $1 : new StatementNode();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building PreprocessorList with: " << $2.view());
+        $$ = $1 ? $1 : ctx->parse_arena.make<StatementNode>();
         $$->type = "PreprocessorList";
-        if ($2 && !$2->empty()) {
-            $$->children.push_back(new ASTNode("Preprocessor", *$2)); 
+        if (!$2.empty()) {
+            $$->children.push_back(ctx->parse_arena.make<ParseNode>("Preprocessor", $2.view())); 
         }
-        delete $2; 
       }
     ;
 
 declaration_list
-    : /* empty */ { $$ = new std::vector<StatementNode*>(); }
+    : /* empty */ { $$ = ctx->parse_arena.make<StatementList>(); }
     | declaration_list declaration
       { 
-        std::cout << "Adding declaration to declaration_list\n"; // Debug
-        $$ = $1 ? $1 : new std::vector<StatementNode*>();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Adding declaration to declaration_list");
+        $$ = $1 ? $1 : ctx->parse_arena.make<StatementList>();
         if ($2 && !($2->value.empty())) {
             $$->push_back($2);
-        } else {
-            delete $2;
         }
       }
     | declaration_list struct_declaration
       { 
-        std::cout << "Adding struct_declaration to declaration_list\n"; // Debug
-        $$ = $1 ? $1 : new std::vector<StatementNode*>();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Adding struct_declaration to declaration_list");
+        $$ = $1 ? $1 : ctx->parse_arena.make<StatementList>();
         if ($2 && !($2->value.empty())) {
             $$->push_back($2);
-        } else {
-            delete $2;
         }
       }
     ;
 
 function_list
-    : /* empty */ { $$ = new std::vector<FunctionNode*>(); }
+    : /* empty */ { $$ = ctx->parse_arena.make<FunctionList>(); }
     | function_list function
       { 
-        std::cout << "Adding function to function_list\n"; // Debug
-        $$ = $1 ? $1 : new std::vector<FunctionNode*>();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Adding function to function_list");
+        $$ = $1 ? $1 : ctx->parse_arena.make<FunctionList>();
         if ($2 && !$2->name.empty()) {
             $$->push_back($2);
-        } else {
-            delete $2;
         }
       }
     ;
@@ -204,37 +223,33 @@ function_list
 function
     : INT IDENTIFIER LPAREN RPAREN LBRACE statement_list RBRACE
       { 
-        std::cout << "Building FunctionNode: " << ($2 ? *$2 : "null") << "\n"; // Debug
-        $$ = new FunctionNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building FunctionNode: " << $2.view());
+        $$ = ctx->parse_arena.make<FunctionNode>(); 
         $$->return_type = "int"; 
-        $$->name = $2 && !$2->empty() ? *$2 : "unknown"; 
-        $$->statements = $6 && !$6->statements.empty() ? $6->statements : std::vector<StatementNode*>(); 
-        delete $2; 
-        std::cout << "FunctionNode built with " << $$->statements.size() << " statements\n"; // Debug
+        $$->name = $2.text_or("unknown"); 
+        $$->statements = std::move($6->statements);
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "FunctionNode built with " << $$->statements.size() << " statements");
       }
     | VOID IDENTIFIER LPAREN RPAREN LBRACE statement_list RBRACE
       { 
-        std::cout << "Building FunctionNode: " << ($2 ? *$2 : "null") << "\n"; // Debug
-        $$ = new FunctionNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building FunctionNode: " << $2.view());
+        $$ = ctx->parse_arena.make<FunctionNode>(); 
         $$->return_type = "void"; 
-        $$->name = $2 && !$2->empty() ? *$2 : "unknown"; 
-        $$->statements = $6 && !$6->statements.empty() ? $6->statements : std::vector<StatementNode*>(); 
-        delete $2; 
-        std::cout << "FunctionNode built with " << $$->statements.size() << " statements\n"; // Debug
+        $$->name = $2.text_or("unknown"); 
+        $$->statements = std::move($6->statements);
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "FunctionNode built with " << $$->statements.size() << " statements");
       }
     ;
 
 statement_list
-    : /* empty */ { $$ = new StatementNode(); $$->type = "Empty"; }
+    : /* empty */ { $$ = ctx->parse_arena.make<StatementNode>(); $$->type = "Empty"; }
     | statement_list statement
       { 
-        std::cout << "Adding statement to statement_list\n"; // Debug
-        $$ = $1 ? $1 : new StatementNode();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Adding statement to statement_list");
+        $$ = $1 ? $1 : ctx->parse_arena.make<StatementNode>();
         $$->type = "StatementList";
         if ($2 && !$2->value.empty()) {
             $$->statements.push_back($2); 
-        } else {
-            delete $2;
         }
       }
     ;
@@ -242,10 +257,10 @@ statement_list
 statement
     : IDENTIFIER LPAREN expression_list RPAREN SEMICOLON
       { 
-        std::cout << "Building Call: " << ($1 ? *$1 : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Call: " << $1.view());
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Call"; 
-        std::string id = ($1 && !$1->empty()) ? *$1 : "invalid";
+        std::string id($1.text_or("invalid"));
         std::string args = "";
         if ($3 && !$3->empty()) {
             for (size_t i = 0; i < $3->size(); ++i) {
@@ -254,16 +269,15 @@ statement
             }
         }
         $$->value = id + "(" + args + ")";
+        $$->name = id;
         if ($3) {
-            $$->children = *$3; // Transfer ownership
-            delete $3; // Delete the vector
+            $$->children = std::move(*$3);
         }
-        delete $1; 
       }
     | RETURN expression SEMICOLON
       { 
-        std::cout << "Building Return: " << ($2 ? $2->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Return: " << ($2 ? $2->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Return"; 
         $$->value = $2 ? $2->value : "0";
         $$->children.push_back($2); 
@@ -281,8 +295,8 @@ statement
 expression_statement
     : expression SEMICOLON
       { 
-        std::cout << "Building Expression: " << ($1 ? $1->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Expression: " << ($1 ? $1->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Expression"; 
         $$->value = $1 ? $1->value : "unknown";
         $$->children.push_back($1); 
@@ -292,118 +306,117 @@ expression_statement
 declaration
     : FLOAT IDENTIFIER SEMICOLON
       { 
-        std::cout << "Building Declaration: " << ($2 ? *$2 : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Declaration: " << $2.view());
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Declaration"; 
-        std::string id = ($2 && !$2->empty()) ? *$2 : "unknown";
+        std::string id($2.text_or("unknown"));
         $$->value = "float " + id;
-        delete $2; 
       }
     | FLOAT IDENTIFIER ASSIGN expression SEMICOLON
       { 
-        std::cout << "Building Declaration: " << ($2 ? *$2 : "null") << ", " << ($4 ? $4->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Declaration: " << $2.view() << ", " << ($4 ? $4->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Declaration"; 
-        std::string id = ($2 && !$2->empty()) ? *$2 : "unknown";
-        std::string val = ($4 && !$4->value.empty()) ? $4->value : "0.0";
+        std::string id($2.text_or("unknown"));
+        std::string val = ($4 && !$4->value.empty()) ? std::string($4->value) : "0.0";
         $$->value = "float " + id + " = " + val;
         $$->children.push_back($4); 
-        delete $2; 
       }
     ;
 
 local_declaration
     : INT var_decls SEMICOLON
       { 
-        std::cout << "Building Local Declaration\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Local Declaration");
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "LocalDeclaration"; 
         $$->value = "int declarations";
         if ($2 && !$2->empty()) {
-            $$->statements = *$2; // Transfer declarations
+            $$->statements = std::move(*$2);
         }
-        delete $2; 
       }
     ;
 
 var_decls
     : IDENTIFIER
       { 
-        std::cout << "Building VarDecl: " << ($1 ? *$1 : "null") << "\n"; // Debug
-        $$ = new std::vector<StatementNode*>();
-        StatementNode* decl = new StatementNode();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building VarDecl: " << $1.view());
+        $$ = ctx->parse_arena.make<StatementList>();
+        StatementNode* decl = ctx->parse_arena.make<StatementNode>();
         decl->type = "VarDecl";
-        decl->value = "int " + ($1 ? *$1 : "unknown");
+        decl->value = "int " + std::string($1.text_or("unknown"));
+        decl->name = $1.text_or("unknown");
+        decl->type_hint = "int";
         $$->push_back(decl);
-        delete $1; 
       }
     | IDENTIFIER ASSIGN expression
       { 
-        std::cout << "Building VarDecl: " << ($1 ? *$1 : "null") << ", " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new std::vector<StatementNode*>();
-        StatementNode* decl = new StatementNode();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building VarDecl: " << $1.view() << ", " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementList>();
+        StatementNode* decl = ctx->parse_arena.make<StatementNode>();
         decl->type = "VarDecl";
-        std::string id = ($1 && !$1->empty()) ? *$1 : "unknown";
-        std::string val = ($3 && !$3->value.empty()) ? $3->value : "0";
+        std::string id($1.text_or("unknown"));
+        std::string val = ($3 && !$3->value.empty()) ? std::string($3->value) : "0";
         decl->value = "int " + id + " = " + val;
+        decl->name = id;
+        decl->type_hint = "int";
         decl->children.push_back($3);
         $$->push_back(decl);
-        delete $1; 
       }
     | var_decls COMMA IDENTIFIER
       { 
-        std::cout << "Building VarDecl: " << ($3 ? *$3 : "null") << "\n"; // Debug
-        $$ = $1 ? $1 : new std::vector<StatementNode*>();
-        StatementNode* decl = new StatementNode();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building VarDecl: " << $3.view());
+        $$ = $1 ? $1 : ctx->parse_arena.make<StatementList>();
+        StatementNode* decl = ctx->parse_arena.make<StatementNode>();
         decl->type = "VarDecl";
-        decl->value = "int " + ($3 ? *$3 : "unknown");
+        decl->value = "int " + std::string($3.text_or("unknown"));
+        decl->name = $3.text_or("unknown");
+        decl->type_hint = "int";
         $$->push_back(decl);
-        delete $3; 
       }
     | var_decls COMMA IDENTIFIER ASSIGN expression
       { 
-        std::cout << "Building VarDecl: " << ($3 ? *$3 : "null") << ", " << ($5 ? $5->value : "null") << "\n"; // Debug
-        $$ = $1 ? $1 : new std::vector<StatementNode*>();
-        StatementNode* decl = new StatementNode();
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building VarDecl: " << $3.view() << ", " << ($5 ? $5->value : "null"));
+        $$ = $1 ? $1 : ctx->parse_arena.make<StatementList>();
+        StatementNode* decl = ctx->parse_arena.make<StatementNode>();
         decl->type = "VarDecl";
-        std::string id = ($3 && !$3->empty()) ? *$3 : "unknown";
-        std::string val = ($5 && !$5->value.empty()) ? $5->value : "0";
+        std::string id($3.text_or("unknown"));
+        std::string val = ($5 && !$5->value.empty()) ? std::string($5->value) : "0";
         decl->value = "int " + id + " = " + val;
+        decl->name = id;
+        decl->type_hint = "int";
         decl->children.push_back($5);
         $$->push_back(decl);
-        delete $3; 
       }
     ;
 
 if_statement
     : IF LPAREN expression RPAREN LBRACE statement_list RBRACE
       { 
-        std::cout << "Building If: " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building If: " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "If"; 
         $$->value = $3 ? $3->value : "unknown";
         $$->children.push_back($3); 
         if ($6 && !$6->statements.empty()) {
-            $$->statements = $6->statements;
+            $$->statements = std::move($6->statements);
         }
       }
     | IF LPAREN expression RPAREN statement
       { 
-        std::cout << "Building If: " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building If: " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "If"; 
         $$->value = $3 ? $3->value : "unknown";
         $$->children.push_back($3); 
         if ($5 && !$5->value.empty()) {
             $$->statements.push_back($5);
-        } else {
-            delete $5;
         }
       }
     | IF LPAREN expression RPAREN LBRACE statement_list RBRACE ELSE LBRACE statement_list RBRACE
       { 
-        std::cout << "Building If-Else: " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building If-Else: " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "IfElse"; 
         $$->value = $3 ? $3->value : "unknown";
         $$->children.push_back($3); 
@@ -416,20 +429,16 @@ if_statement
       }
     | IF LPAREN expression RPAREN statement ELSE statement
       { 
-        std::cout << "Building If-Else: " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building If-Else: " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "IfElse"; 
         $$->value = $3 ? $3->value : "unknown";
         $$->children.push_back($3); 
         if ($5 && !$5->value.empty()) {
             $$->statements.push_back($5);
-        } else {
-            delete $5;
         }
         if ($7 && !$7->value.empty()) {
             $$->statements.push_back($7);
-        } else {
-            delete $7;
         }
       }
     ;
@@ -437,33 +446,29 @@ if_statement
 for_statement
     : FOR LPAREN local_declaration expression SEMICOLON incr_expression RPAREN LBRACE statement_list RBRACE
       { 
-        std::cout << "Building For\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building For");
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "For"; 
         $$->value = ($4 ? $4->value : "unknown");
-        $$->children.push_back(new ASTNode("Init", $3->value)); 
+        $$->children.push_back(ctx->parse_arena.make<ParseNode>("Init", $3->value)); 
         $$->children.push_back($4); 
         $$->children.push_back($6); 
         if ($9 && !$9->statements.empty()) {
-            $$->statements = $9->statements;
+            $$->statements = std::move($9->statements);
         }
-        delete $3; 
       }
     | FOR LPAREN local_declaration expression SEMICOLON incr_expression RPAREN statement
       { 
-        std::cout << "Building For\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building For");
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "For"; 
         $$->value = ($4 ? $4->value : "unknown");
-        $$->children.push_back(new ASTNode("Init", $3->value)); 
+        $$->children.push_back(ctx->parse_arena.make<ParseNode>("Init", $3->value)); 
         $$->children.push_back($4); 
         $$->children.push_back($6); 
         if ($8 && !$8->value.empty()) {
             $$->statements.push_back($8);
-        } else {
-            delete $8;
         }
-        delete $3; 
       }
     ;
 
@@ -472,43 +477,39 @@ incr_expression
       { $$ = $1; }
     | IDENTIFIER PLUSPLUS
       { 
-        std::cout << "Building Increment: " << ($1 ? *$1 : "null") << "\n"; // Debug
-        $$ = new ASTNode("Increment", ($1 ? *$1 : "unknown") + "++");
-        $$->children.push_back(new ASTNode("Identifier", $1 ? *$1 : "unknown"));
-        delete $1; 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Increment: " << $1.view());
+        $$ = ctx->parse_arena.make<ParseNode>("Increment", std::string($1.text_or("unknown")) + "++");
+        $$->children.push_back(ctx->parse_arena.make<ParseNode>("Identifier", $1.text_or("unknown")));
       }
     | PLUSPLUS IDENTIFIER
       { 
-        std::cout << "Building PreIncrement: " << ($2 ? *$2 : "null") << "\n"; // Debug
-        $$ = new ASTNode("PreIncrement", "++" + ($2 ? *$2 : "unknown"));
-        $$->children.push_back(new ASTNode("Identifier", $2 ? *$2 : "unknown"));
-        delete $2; 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building PreIncrement: " << $2.view());
+        $$ = ctx->parse_arena.make<ParseNode>("PreIncrement", "++" + std::string($2.text_or("unknown")));
+        $$->children.push_back(ctx->parse_arena.make<ParseNode>("Identifier", $2.text_or("unknown")));
       }
     ;
 
 while_statement
     : WHILE LPAREN expression RPAREN LBRACE statement_list RBRACE
       { 
-        std::cout << "Building While: " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building While: " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "While"; 
         $$->value = $3 ? $3->value : "unknown";
         $$->children.push_back($3); 
         if ($6 && !$6->statements.empty()) {
-            $$->statements = $6->statements;
+            $$->statements = std::move($6->statements);
         }
       }
     | WHILE LPAREN expression RPAREN statement
       { 
-        std::cout << "Building While: " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building While: " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "While"; 
         $$->value = $3 ? $3->value : "unknown";
         $$->children.push_back($3); 
         if ($5 && !$5->value.empty()) {
             $$->statements.push_back($5);
-        } else {
-            delete $5;
         }
       }
     ;
@@ -516,66 +517,62 @@ while_statement
 struct_declaration
     : STRUCT IDENTIFIER LBRACE declaration_list RBRACE SEMICOLON
       { 
-        std::cout << "Building Struct: " << ($2 ? *$2 : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Struct: " << $2.view());
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Struct"; 
-        std::string id = ($2 && !$2->empty()) ? *$2 : "unknown";
+        std::string id($2.text_or("unknown"));
         $$->value = "struct " + id;
         if ($4 && !$4->empty()) {
             for (const auto* decl : *$4) {
                 if (decl && !decl->value.empty()) {
-                    $$->children.push_back(new ASTNode(decl->type, decl->value));
+                    $$->children.push_back(ctx->parse_arena.make<ParseNode>(decl->type, decl->value));
                 }
             }
         }
-        delete $2; 
-        delete $4; // Delete the vector
       }
     ;
 
 assignment_statement
     : IDENTIFIER ASSIGN expression SEMICOLON
       { 
-        std::cout << "Building Assignment: " << ($1 ? *$1 : "null") << ", " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Assignment: " << $1.view() << ", " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Assignment"; 
-        std::string id = ($1 && !$1->empty()) ? *$1 : "unknown";
-        std::string val = ($3 && !$3->value.empty()) ? $3->value : "0";
+        std::string id($1.text_or("unknown"));
+        std::string val = ($3 && !$3->value.empty()) ? std::string($3->value) : "0";
         $$->value = id + " = " + val;
+        $$->name = id;
         $$->children.push_back($3); 
-        delete $1; 
       }
     | IDENTIFIER MULTEQ expression SEMICOLON
       { 
-        std::cout << "Building Assignment: " << ($1 ? *$1 : "null") << ", " << ($3 ? $3->value : "null") << "\n"; // Debug
-        $$ = new StatementNode(); 
+        UC_TRACE(TraceLevel::Debug, TraceCategory::Parser, "Building Assignment: " << $1.view() << ", " << ($3 ? $3->value : "null"));
+        $$ = ctx->parse_arena.make<StatementNode>(); 
         $$->type = "Assignment"; 
-        std::string id = ($1 && !$1->empty()) ? *$1 : "unknown";
-        std::string val = ($3 && !$3->value.empty()) ? $3->value : "0";
+        std::string id($1.text_or("unknown"));
+        std::string val = ($3 && !$3->value.empty()) ? std::string($3->value) : "0";
         $$->value = id + " *= " + val;
+        // The AST has no compound assignment: the target keeps the operator, so analysis reports
+        // it rather than taking it for a plain store
+        $$->name = id + " *";
         $$->children.push_back($3); 
-        delete $1; 
       }
     ;
 
 expression_list
-    : /* empty */ { $$ = new std::vector<ASTNode*>(); }
+    : /* empty */ { $$ = ctx->parse_arena.make<ExpressionList>(); }
     | expression
       { 
-        $$ = new std::vector<ASTNode*>();
+        $$ = ctx->parse_arena.make<ExpressionList>();
         if ($1 && !$1->value.empty()) {
             $$->push_back($1);
-        } else {
-            delete $1;
         }
       }
     | expression_list COMMA expression
       { 
-        $$ = $1 ? $1 : new std::vector<ASTNode*>();
+        $$ = $1 ? $1 : ctx->parse_arena.make<ExpressionList>();
         if ($3 && !$3->value.empty()) {
             $$->push_back($3);
-        } else {
-            delete $3;
         }
       }
     ;
@@ -584,61 +581,61 @@ expression
     : term { $$ = $1; }
     | expression PLUS term
       { 
-        $$ = new ASTNode("Add", ($1 ? $1->value : "0") + " + " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Add", ($1 ? $1->value : "0") + " + " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression MINUS term
       { 
-        $$ = new ASTNode("Subtract", ($1 ? $1->value : "0") + " - " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Subtract", ($1 ? $1->value : "0") + " - " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression MULT term
       { 
-        $$ = new ASTNode("Multiply", ($1 ? $1->value : "0") + " * " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Multiply", ($1 ? $1->value : "0") + " * " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression DIV term
       { 
-        $$ = new ASTNode("Divide", ($1 ? $1->value : "0") + " / " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Divide", ($1 ? $1->value : "0") + " / " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression MOD term
       { 
-        $$ = new ASTNode("Modulo", ($1 ? $1->value : "0") + " % " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Modulo", ($1 ? $1->value : "0") + " % " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression GT term
       { 
-        $$ = new ASTNode("Greater", ($1 ? $1->value : "0") + " > " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Greater", ($1 ? $1->value : "0") + " > " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression LT term
       { 
-        $$ = new ASTNode("Less", ($1 ? $1->value : "0") + " < " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Less", ($1 ? $1->value : "0") + " < " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression LE term
       { 
-        $$ = new ASTNode("LessEqual", ($1 ? $1->value : "0") + " <= " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("LessEqual", ($1 ? $1->value : "0") + " <= " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | expression EQ term
       { 
-        $$ = new ASTNode("Equal", ($1 ? $1->value : "0") + " == " + ($3 ? $3->value : "0")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Equal", ($1 ? $1->value : "0") + " == " + ($3 ? $3->value : "0")); 
         $$->children.push_back($1);
         $$->children.push_back($3);
       }
     | ADDRESS term
       { 
-        $$ = new ASTNode("Address", "&" + ($2 ? $2->value : "unknown")); 
+        $$ = ctx->parse_arena.make<ParseNode>("Address", "&" + ($2 ? $2->value : "unknown")); 
         $$->children.push_back($2);
       }
     ;
@@ -646,31 +643,54 @@ expression
 term
     : IDENTIFIER
       { 
-        $$ = new ASTNode("Identifier", $1 ? *$1 : "unknown");
-        delete $1;
+        $$ = ctx->parse_arena.make<ParseNode>("Identifier", $1.text_or("unknown"));
       }
     | NUMBER
       { 
-        $$ = new ASTNode("Number", $1 ? *$1 : "0");
-        delete $1;
+        $$ = ctx->parse_arena.make<ParseNode>("Number", $1.text_or("0"));
       }
     | STRING
       { 
-        $$ = new ASTNode("String", $1 ? *$1 : "\"\"");
-        delete $1;
+        $$ = ctx->parse_arena.make<ParseNode>("String", $1.text_or("\"\""));
       }
     | LPAREN expression RPAREN { $$ = $2; }
     | IDENTIFIER PLUSPLUS
       { 
-        $$ = new ASTNode("Increment", ($1 ? *$1 : "unknown") + "++");
-        $$->children.push_back(new ASTNode("Identifier", $1 ? *$1 : "unknown"));
-        delete $1;
+        $$ = ctx->parse_arena.make<ParseNode>("Increment", std::string($1.text_or("unknown")) + "++");
+        $$->children.push_back(ctx->parse_arena.make<ParseNode>("Identifier", $1.text_or("unknown")));
       }
     | PLUSPLUS IDENTIFIER
       { 
-        $$ = new ASTNode("PreIncrement", "++" + ($2 ? *$2 : "unknown"));
-        $$->children.push_back(new ASTNode("Identifier", $2 ? *$2 : "unknown"));
-        delete $2;
+        $$ = ctx->parse_arena.make<ParseNode>("PreIncrement", "++" + std::string($2.text_or("unknown")));
+        $$->children.push_back(ctx->parse_arena.make<ParseNode>("Identifier", $2.text_or("unknown")));
       }
     ;
 %%
+
+// --pipeline: tokens are pushed into the parser as the lexer thread delivers them. Text and
+// positions come with each token, so nothing here reads ctx while the lexer thread owns it.
+int pipelinedParse(FrontendContext* ctx, TokenPipeline& pipeline) {
+    yypstate* parser = yypstate_new();
+    if (parser == nullptr) {
+        std::cerr << "Error: Could not allocate the parser\n";
+        return 2;
+    }
+    int status = YYPUSH_MORE;
+    YYSTYPE value;
+    while (status == YYPUSH_MORE) {
+        const PipelinedToken* item = pipeline.next();
+        int kind = 0; // EOF
+        if (item != nullptr && item->token.kind == TokenKind::Unknown) {
+            std::cerr << "Unknown token: " << item->text << " at line " << item->line << "\n";
+            kind = -1; // Error
+        } else if (item != nullptr) {
+            kind = parserToken(&item->token, item->text, &value);
+            if (kind == kSkippedToken) {
+                continue;
+            }
+        }
+        status = yypush_parse(parser, kind, &value, ctx);
+    }
+    yypstate_delete(parser);
+    return status;
+}
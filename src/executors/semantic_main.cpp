@@ -1,12 +1,12 @@
 #include "../include/Parser.h"
+#include "../include/parser_utils.hpp"
 #include "../include/SemanticAnalyzer.h"
 #include "../include/SymbolTable.h"
 #include <iostream>
 
-void runSemanticAnalysis(const char* filename) {
+void runSemanticAnalysis(const ProgramNode& program, bool shareExpressions) {
     try {
-        std::shared_ptr<ASTNode> ast = readASTFromFile(filename);
-        SemanticAnalyzer analyzer(ast);
+        SemanticAnalyzer analyzer(buildAST(program, shareExpressions));
         analyzer.analyzeSemantics();
         const auto& issues = analyzer.getIssues();
         if (!issues.empty()) {
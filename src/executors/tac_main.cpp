@@ -1,12 +1,13 @@
 #include "../include/Parser.h"
+#include "../include/parser_utils.hpp"
 #include "../include/SemanticAnalyzer.h"
 #include "../include/SymbolTable.h"
 #include <iostream>
 
-void runTACGeneration(const char* filename) {
+// TAC is always built from an unshared AST (see AST::Builder)
+void runTACGeneration(const ProgramNode& program) {
     try {
-        std::shared_ptr<ASTNode> ast = readASTFromFile(filename);
-        SemanticAnalyzer analyzer(ast);
+        SemanticAnalyzer analyzer(buildAST(program));
         analyzer.generateTACOnly();
         const auto& issues = analyzer.getIssues();
         if (!issues.empty()) {
@@ -21,10 +22,9 @@ void runTACGeneration(const char* filename) {
     }
 }
 
-void runTargetCodeGeneration(const char* filename) {
+void runTargetCodeGeneration(const ProgramNode& program) {
     try {
-        std::shared_ptr<ASTNode> ast = readASTFromFile(filename);
-        SemanticAnalyzer analyzer(ast);
+        SemanticAnalyzer analyzer(buildAST(program));
         analyzer.generateTargetCodeOnly();
         const auto& issues = analyzer.getIssues();
         if (!issues.empty()) {
@@ -1,10 +1,13 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <string>
-#include <vector>
-#include <memory>
 #include <unordered_map>
+#include <vector>
+#include <string_view>
+#include "StringPool.h"
 
-enum class NodeType {
+enum class NodeType : uint8_t {
     Program,
     Preprocessor,
     Struct,
@@ -42,17 +45,226 @@ enum class NodeType {
     Update         // For loop update
 };
 
+using NodeId = uint32_t;
+inline constexpr NodeId kNoNode = UINT32_MAX;
+
+// One node of an AST, stored by value in the AST's node array. Text is held as interned names
+// and structure as indices, so a node is a few dozen bytes with no heap allocation of its own.
 struct ASTNode {
+    Name value;
+    Name typeHint;
+    Name callString;             // Store full call string for Call nodes
+    Name cachedType;             // Type found by semantic analysis; empty until then
+    int line = 1;
+    NodeId firstChild = kNoNode;
+    NodeId nextSibling = kNoNode;
+    uint32_t childCount = 0;
+    NodeType type = NodeType::Program;
+};
+
+class AST;
+
+// Handle to one node: an AST and an index, cheap to copy and pass by value. Children are reached
+// through the first-child/next-sibling links. A node shared by repeated expressions is reached once
+// per occurrence, and the handle carries how far that occurrence's lines are from the stored ones.
+class ASTRef {
+private:
+    AST* tree = nullptr;
+    NodeId id = kNoNode;
+    int lineShift = 0;
+
+    ASTNode& node() const;
+    int childLineShift() const;
+
+public:
+    ASTRef() = default;
+    ASTRef(AST* ast, NodeId index, int shift = 0) : tree(ast), id(index), lineShift(shift) {}
+
+    explicit operator bool() const { return id != kNoNode; }
+    NodeId index() const { return id; }
+
+    NodeType type() const { return node().type; }
+    Name value() const { return node().value; }
+    Name typeHint() const { return node().typeHint; }
+    Name callString() const { return node().callString; }
+    // Line of this occurrence: a shared node gives the line of the expression it was reached through
+    int line() const { return node().line + lineShift; }
+    Name cachedType() const { return node().cachedType; }
+    void setCachedType(Name type) const { node().cachedType = type; }
+
+    size_t childCount() const { return node().childCount; }
+    bool hasChildren() const { return node().firstChild != kNoNode; }
+    // The next child of this node's parent; a null handle after the last one
+    ASTRef nextSibling() const { return ASTRef(tree, node().nextSibling, lineShift); }
+    // The i-th child; walks i sibling links, which is short for every node type we have
+    ASTRef child(size_t i) const;
+
+    // Iterates the children in order
+    class ChildIterator {
+    private:
+        AST* tree;
+        NodeId id;
+        int lineShift;
+
+    public:
+        ChildIterator(AST* ast, NodeId index, int shift = 0) : tree(ast), id(index), lineShift(shift) {}
+        ASTRef operator*() const { return ASTRef(tree, id, lineShift); }
+        ChildIterator& operator++();
+        bool operator!=(const ChildIterator& other) const { return id != other.id; }
+    };
+    struct ChildRange {
+        ChildIterator first;
+        ChildIterator begin() const { return first; }
+        ChildIterator end() const { return ChildIterator(nullptr, kNoNode); }
+    };
+    ChildRange children() const { return ChildRange{ChildIterator(tree, node().firstChild, childLineShift())}; }
+};
+
+// Whole AST in one array, in preorder, so passes over it walk memory mostly front to back
+class AST {
+private:
+    std::vector<ASTNode> nodes;
+    // Per node, only when expressions are shared: how many lines after the first expression like it
+    // a repeated one is (0 for every other node), so its borrowed children can be given its lines
+    std::vector<int> lineShifts;
+    NodeId rootId = kNoNode;
+
+    friend class ASTRef;
+
+public:
+    // Appends nodes in preorder, given each one's depth (0 for the root); a second node at depth 0
+    // replaces the root, as the text AST reader has always done.
+    //
+    // With shareExpressions, pure expressions are hash-consed as they are completed: an expression
+    // the same as one built earlier keeps a node of its own (for its line and its place among its
+    // siblings) but takes the earlier one's children, and its own are dropped. Shared children carry
+    // one cached type, so analysis types a repeated operand once. The repeated node's entry in
+    // lineShifts gives handles reached through it that occurrence's lines (nodes are numbered one
+    // line each in preorder, so its subtree sits the same distance further down). TAC is not built
+    // from shared trees: its value numbering goes by register, not by node, and a shared operand
+    // typed elsewhere would be loaded again. Expressions are only shared while the names in them
+    // mean the same thing: a function or declaration starts afresh, and so does an IfElse
+    // condition, which the analyzer types before the branches built ahead of it.
+    class Builder {
+    private:
+        struct Open {
+            NodeId node;
+            NodeId lastChild;
+        };
+        AST& ast;
+        std::vector<Open> open; // The last node added and its ancestors, root first
+        bool sharing;
+        std::vector<NodeId> canonical;             // Per node: the first expression like it, or kNoNode
+        std::unordered_map<uint64_t, NodeId> seen; // Structural hash -> first expression with it
+
+        void close();
+        bool sameExpression(NodeId a, NodeId b) const;
+
+    public:
+        explicit Builder(AST& tree, bool shareExpressions = false) : ast(tree), sharing(shareExpressions) {}
+        NodeId add(size_t depth, const ASTNode& node);
+    };
+
+    bool empty() const { return rootId == kNoNode; }
+    size_t size() const { return nodes.size(); }
+    ASTRef root() { return ASTRef(this, rootId); }
+};
+
+inline ASTNode& ASTRef::node() const { return tree->nodes[id]; }
+
+inline int ASTRef::childLineShift() const {
+    return tree->lineShifts.empty() ? lineShift : lineShift + tree->lineShifts[id];
+}
+
+inline ASTRef ASTRef::child(size_t i) const {
+    NodeId next = node().firstChild;
+    while (i-- > 0) {
+        next = tree->nodes[next].nextSibling;
+    }
+    return ASTRef(tree, next, childLineShift());
+}
+
+inline ASTRef::ChildIterator& ASTRef::ChildIterator::operator++() {
+    id = tree->nodes[id].nextSibling;
+    return *this;
+}
+
+// Node types the text AST can name, spelled as it spells them
+struct NodeTypeName {
+    std::string_view name;
     NodeType type;
-    std::string value;
-    std::string typeHint;
-    std::string callString; // Store full call string for Call nodes
-    int line;
-    std::string cachedType;
-    std::vector<std::shared_ptr<ASTNode>> children;
-    
-    ASTNode(NodeType t, std::string val = "", std::string th = "", std::string cs = "", int l = 1);
 };
 
-// Declare nodeTypeMap as extern to be defined in AST.cpp
-extern std::unordered_map<std::string, NodeType> nodeTypeMap;
\ No newline at end of file
+inline constexpr NodeTypeName kNodeTypeNames[] = {
+    {"Program", NodeType::Program},
+    {"Preprocessor", NodeType::Preprocessor},
+    {"Struct", NodeType::Struct},
+    {"Function", NodeType::Function},
+    {"Declarations", NodeType::Declarations},
+    {"LocalDeclaration", NodeType::LocalDeclaration},
+    {"VarDecl", NodeType::VarDecl},
+    {"Assignment", NodeType::Assignment},
+    {"While", NodeType::While},
+    {"Call", NodeType::Call},
+    {"IfElse", NodeType::IfElse},
+    {"Return", NodeType::Return},
+    {"Identifier", NodeType::Identifier},
+    {"Number", NodeType::Number},
+    {"String", NodeType::String},
+    {"Address", NodeType::Address},
+    {"Modulo", NodeType::Modulo},
+    {"Equal", NodeType::Equal},
+    {"Add", NodeType::Add},
+    {"Less", NodeType::Less},
+    {"Increment", NodeType::Increment}
+};
+
+inline constexpr size_t kNodeTypeNameCount = sizeof(kNodeTypeNames) / sizeof(kNodeTypeNames[0]);
+
+// Perfect hash over the node type names from their first and last letters and length, so a lookup
+// reads two bytes instead of the whole name; the multiplier is searched at compile time until
+// every name lands in its own slot of a 64-entry table
+constexpr uint32_t nodeTypeSlot(std::string_view name, uint32_t multiplier) {
+    return (static_cast<uint8_t>(name.front()) * multiplier + static_cast<uint32_t>(name.size()) +
+            static_cast<uint8_t>(name.back())) & 63u;
+}
+
+struct NodeTypeTable {
+    uint32_t multiplier;
+    std::array<uint8_t, 64> slots; // Index in kNodeTypeNames + 1, 0 for an empty slot
+};
+
+constexpr NodeTypeTable buildNodeTypeTable() {
+    for (uint32_t multiplier = 1; multiplier < 256; ++multiplier) {
+        NodeTypeTable table{multiplier, {}};
+        bool collision = false;
+        for (size_t i = 0; i < kNodeTypeNameCount && !collision; ++i) {
+            uint8_t& slot = table.slots[nodeTypeSlot(kNodeTypeNames[i].name, multiplier)];
+            collision = slot != 0;
+            slot = static_cast<uint8_t>(i + 1);
+        }
+        if (!collision) return table;
+    }
+    return NodeTypeTable{0, {}};
+}
+
+inline constexpr NodeTypeTable kNodeTypeTable = buildNodeTypeTable();
+static_assert(kNodeTypeTable.multiplier != 0, "No perfect hash multiplier found for the node type names");
+
+// Looks name up in kNodeTypeNames with one hash and one compare; false when it is not there
+constexpr bool findNodeType(std::string_view name, NodeType& type) {
+    if (name.empty()) {
+        return false;
+    }
+    uint8_t slot = kNodeTypeTable.slots[nodeTypeSlot(name, kNodeTypeTable.multiplier)];
+    if (slot == 0 || kNodeTypeNames[slot - 1].name != name) {
+        return false;
+    }
+    type = kNodeTypeNames[slot - 1].type;
+    return true;
+}
+
+static_assert([] {
+    NodeType type{};
+    return findNodeType("IfElse", type) && type == NodeType::IfElse && !findNodeType("If", type);
+}(), "Perfect hash lookup is broken");
\ No newline at end of file
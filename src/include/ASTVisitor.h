@@ -0,0 +1,72 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "AST.h"
+
+// A node waiting on a walk's stack: which step of it to run, and how deep it is
+struct ASTWalkFrame {
+    ASTRef node;
+    uint32_t step;
+    uint32_t depth;
+};
+
+// Frames of every walk in progress. Walks can share one: a walk started from inside another's
+// visit (say, typing an expression while analyzing a statement) runs above the outer walk's frames
+// and leaves them as it found them, so a stack that has grown once is not allocated again.
+using ASTWalkStack = std::vector<ASTWalkFrame>;
+
+// What a visit can schedule. Whatever one visit schedules runs in the order it was scheduled, and
+// all of it (the children's own work included) runs before anything scheduled earlier:
+// visitChildren(node) then resume(node, 1) is a post-order hook.
+class ASTWalk {
+protected:
+    ASTWalkStack& stack;
+    uint32_t currentDepth = 0;
+
+    explicit ASTWalk(ASTWalkStack& frames) : stack(frames) {}
+
+public:
+    // Depth of the node being visited; the root of the walk is at 0
+    uint32_t depth() const { return currentDepth; }
+
+    void visitChild(ASTRef child) { stack.push_back(ASTWalkFrame{child, 0, currentDepth + 1}); }
+    // Schedules first and every sibling after it
+    void visitSiblings(ASTRef first) {
+        for (ASTRef child = first; child; child = child.nextSibling()) {
+            visitChild(child);
+        }
+    }
+    void visitChildren(ASTRef node) { visitSiblings(node.child(0)); }
+    // Runs step of the node being visited again once everything scheduled before it is done
+    void resume(ASTRef node, uint32_t step) { stack.push_back(ASTWalkFrame{node, step, currentDepth}); }
+};
+
+// Base of the passes over an AST. A pass derives from ASTVisitor<Pass> and defines
+//
+//     void visit(ASTRef node, uint32_t step);
+//
+// which run() calls through the derived type, so each pass's switch over NodeType is reached
+// without a virtual call. run() starts with the root at step 0 and keeps going until nothing it
+// scheduled is left; the walk is a loop over its own stack, so a deeply nested tree costs heap,
+// not call stack.
+template <typename Pass>
+class ASTVisitor : public ASTWalk {
+protected:
+    explicit ASTVisitor(ASTWalkStack& frames) : ASTWalk(frames) {}
+
+public:
+    void run(ASTRef root) {
+        size_t base = stack.size();
+        stack.push_back(ASTWalkFrame{root, 0, 0});
+        while (stack.size() > base) {
+            ASTWalkFrame frame = stack.back();
+            stack.pop_back();
+            currentDepth = frame.depth;
+            size_t scheduled = stack.size();
+            static_cast<Pass*>(this)->visit(frame.node, frame.step);
+            // Pushed first to last; flipped so the first is popped first
+            std::reverse(stack.begin() + scheduled, stack.end());
+        }
+    }
+};
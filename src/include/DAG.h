@@ -2,13 +2,14 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "StringPool.h"
 
 // DAG node for expression optimization
 struct DAGNode {
-    std::string op;
-    std::string value;
+    Name op;
+    Name value;
     std::vector<std::shared_ptr<DAGNode>> children;
-    std::string result;
+    Name result;
     int id;
-    DAGNode(const std::string& o, const std::string& v, int i);
+    DAGNode(Name o, Name v, int i);
 };
\ No newline at end of file
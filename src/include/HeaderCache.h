@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "token_iterator.hpp"
+#include "LineIndex.h"
+
+struct FrontendContext;
+
+// A header lexed on its own, with no macros applied and no nested #include followed, so the same
+// tokens serve every file that includes it whatever is defined at that point. Macros, conditionals
+// and nested includes are dealt with each time the tokens are spliced into a compilation.
+struct HeaderEntry {
+    std::string path;
+    std::filesystem::file_time_type modified;
+    uintmax_t size = 0;
+    StringPool strings; // Spellings of tokens and unknown_tokens (copied; the file is not kept open)
+    std::vector<Tokens> tokens;
+    std::vector<UnknownTokens> unknown_tokens;
+    LineIndex lines;
+    std::string guard;  // X when the whole file is #ifndef X / #define X ... #endif, otherwise empty
+};
+
+// Counters for --stats
+struct HeaderCacheStats {
+    uint64_t hits = 0;        // Includes served from the cache
+    uint64_t misses = 0;      // Headers lexed: first use, or changed on disk since
+    uint64_t guardSkips = 0;  // Re-inclusions dropped because their guard macro was defined
+};
+
+// Process-wide cache of header token streams, keyed by resolved path and checked against the
+// file's size and modification time on each use. Entries never change once published, so
+// compilations on separate threads share them; a changed file gets a fresh entry while earlier
+// users keep the one they hold.
+class HeaderCache {
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const HeaderEntry>> entries;
+    HeaderCacheStats counters;
+
+public:
+    static HeaderCache& shared();
+
+    // Tokens of the header at path (already resolved), lexed now if needed; nullptr if it cannot be read
+    std::shared_ptr<const HeaderEntry> get(const std::string& path);
+    void noteGuardSkip();
+    HeaderCacheStats stats() const;
+    void printStats(std::ostream& os) const;
+    void clear();
+};
+
+// Splices the header named by a quoted #include (name without the quotes) into ctx's token sink,
+// applying and updating ctx's macros as the scanner would have. The name is looked up next to
+// from, the including file, and then in ctx.include_dirs. A header whose guard macro is already
+// defined is skipped without being read.
+void expandInclude(FrontendContext& ctx, const std::string& name, const std::string& from, int depth = 0);
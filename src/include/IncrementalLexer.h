@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct FrontendContext;
+
+// Replace removed bytes at offset with inserted
+struct SourceEdit {
+    uint32_t offset;
+    uint32_t removed;
+    std::string inserted;
+};
+
+// What the last apply() did
+struct IncrementalLexStats {
+    bool full = false;           // The whole file was lexed again
+    uint32_t relexBegin = 0;     // Bytes of the edited text that were scanned
+    uint32_t relexEnd = 0;
+    size_t tokensReplaced = 0;   // Old tokens dropped
+    size_t tokensInserted = 0;   // New tokens spliced in their place
+};
+
+// Keeps ctx's token stream current while the source is edited (editor and watch workflows).
+// An edit is re-lexed from the last token that starts far enough ahead of it for no earlier match
+// to have looked at the edited bytes, until the new matches fall back in step with the old
+// tokens; the new tokens are then spliced in and the old tail is shifted by the size change.
+// The whole file is lexed again when it holds a comment or literal left open (its scan looks
+// ahead to the end of the file), or when the edit adds, drops or changes a directive. A scan that
+// restarts inside #ifdef/#ifndef branches takes the open conditionals from the tokens before it.
+// Only the edited file's own tokens are kept: quoted #includes are not expanded, since header
+// tokens carry offsets into their own files and would break the offset order edits rely on.
+class IncrementalLexer {
+private:
+    FrontendContext& ctx;
+    bool openConstruct = false; // The last scan met a comment or literal left open
+    IncrementalLexStats stats;
+
+    void relexAll();
+
+public:
+    explicit IncrementalLexer(FrontendContext& context);
+
+    // Full lex of filename; its text is then held in ctx.source and edited there
+    bool open(const char* filename);
+    // Applies edit to the text and brings the tokens up to date; false if it is out of range
+    bool apply(const SourceEdit& edit);
+
+    const IncrementalLexStats& lastStats() const { return stats; }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 1-based line and byte column of a source offset
+struct SourcePosition {
+    uint32_t line;
+    uint32_t column;
+};
+
+// Byte offset of every line start in a source file, so tokens only need to carry their offset.
+// Built in one pass with the newline kernel (ScanKernels.h); a lookup is a binary search.
+class LineIndex {
+private:
+    std::vector<uint32_t> starts; // starts[0] == 0
+    bool built = false;
+
+    void addLineStarts(const char* begin, const char* end, uint32_t base);
+
+public:
+    void clear();
+    bool isBuilt() const { return built; }
+    size_t lineCount() const { return starts.size(); }
+
+    void build(const char* begin, const char* end);
+    // For sources that are not held in memory: reads the file in fixed-size blocks
+    bool buildFromFile(const std::string& path);
+
+    SourcePosition position(uint32_t offset) const;
+
+    // Line starts as built, and an index made from ones saved earlier (PreludeSnapshot.h)
+    const std::vector<uint32_t>& lineStarts() const { return starts; }
+    void assign(std::vector<uint32_t> lineStarts);
+};
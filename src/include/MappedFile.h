@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A whole file in memory, followed by two NUL bytes (what flex's yy_scan_buffer expects).
+// Regular files are mmap'd copy-on-write, so the contents are never staged through stdio;
+// anything that cannot be mapped is read into a heap buffer instead.
+class MappedFile {
+private:
+    char* base;
+    size_t length;        // File contents, excluding the NUL padding
+    size_t mappedLength;  // Bytes reserved by mmap, 0 when the heap buffer is in use
+    std::vector<char> heap;
+
+    bool readIntoHeap(const std::string& path);
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    // Padded private copy of text, so part of another buffer can be scanned on its own
+    void assign(std::string_view text);
+    // Replace count bytes at offset with text; a mapped file is first copied to the heap
+    void replace(size_t offset, size_t count, std::string_view text);
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    bool isMapped() const { return mappedLength != 0; }
+    char* data() { return base; }
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+    size_t paddedSize() const { return length + 2; }
+    std::string_view view() const { return std::string_view(base, length); }
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+struct FrontendContext;
+
+// Lexes ctx.source (already mapped, scanner state reset) on several threads. The file is cut into
+// chunks at line starts; each chunk is scanned on its own copy, on the guess that it starts
+// between tokens and with no macros defined. The chunks are then stitched together in order:
+// a chunk whose guess was wrong (the previous one ran into it, it left a comment or literal open,
+// or it uses a macro defined before it) is re-lexed serially until a match starts on a later chunk
+// boundary again. Token offsets are file offsets throughout, so nothing needs rebasing, and the
+// result is the token stream the serial scanner produces.
+// Returns false, leaving ctx untouched, when the file is too small or the setup does not allow it.
+bool lexSourceInParallel(FrontendContext& ctx);
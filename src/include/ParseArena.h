@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory_resource>
+#include <new>
+#include <ostream>
+#include <string>
+#include <utility>
+
+// Counters for --stats
+struct ParseArenaStats {
+    uint64_t nodes = 0;   // Nodes and lists built with make()
+    uint64_t chunks = 0;  // Heap allocations behind them
+    uint64_t bytes = 0;   // Total size of those chunks
+};
+
+// Owns every node and list the grammar builds in one parse. Objects are bump-allocated from chunks
+// that grow geometrically, so a parse costs O(log n) heap allocations. The strings and vectors
+// inside the nodes allocate from the same chunks (std::pmr), so release() frees the whole tree a
+// chunk at a time: no node is visited and no destructor runs.
+class ParseArena {
+private:
+    // Passes chunk requests on to the heap, counting them
+    class ChunkSource : public std::pmr::memory_resource {
+    private:
+        ParseArenaStats& counters;
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            counters.chunks++;
+            counters.bytes += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* chunk, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(chunk, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    public:
+        explicit ChunkSource(ParseArenaStats& stats) : counters(stats) {}
+    };
+
+    static constexpr size_t kFirstChunk = 16 * 1024;
+
+    ParseArenaStats counters;
+    ChunkSource chunks{counters};
+    std::pmr::monotonic_buffer_resource memory{kFirstChunk, &chunks};
+
+public:
+    ParseArena() = default;
+    ParseArena(const ParseArena&) = delete;
+    ParseArena& operator=(const ParseArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &memory; }
+
+    // A T built in the arena; T's constructor takes the arena's memory resource first
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        counters.nodes++;
+        void* slot = memory.allocate(sizeof(T), alignof(T));
+        return ::new (slot) T(&memory, std::forward<Args>(args)...);
+    }
+
+    // Frees everything made so far; the counters keep the totals
+    void release() { memory.release(); }
+
+    const ParseArenaStats& stats() const { return counters; }
+    void printStats(std::ostream& os) const {
+        os << "Parse arena statistics\n";
+        os << std::string(40, '-') << "\n";
+        os << std::left << std::setw(24) << "Nodes and lists" << counters.nodes << "\n";
+        os << std::left << std::setw(24) << "Chunk allocations" << counters.chunks << "\n";
+        os << std::left << std::setw(24) << "Chunk bytes" << counters.bytes << "\n";
+        os << std::string(40, '-') << "\n";
+    }
+};
@@ -1,15 +1,30 @@
 #pragma once
 #include "AST.h"
 #include <string>
-#include <memory>
+#include <string_view>
 
+// One classified line of the text AST; the views point into the line it came from
 struct ParsedNode {
     NodeType type;
-    std::string value;
-    std::string typeHint;
-    std::string callString; // Store full call string for Call nodes
+    std::string_view value;
+    std::string_view typeHint;
+    std::string_view callString; // Store full call string for Call nodes
     int line;
-    ParsedNode(NodeType t, const std::string& val, const std::string& th, const std::string& cs, int l);
 };
 
-std::shared_ptr<ASTNode> readASTFromFile(const std::string& filename);
\ No newline at end of file
+class ProgramNode;
+
+// One line of the text AST: nodeTypeStr is the text before the colon, rest the (left-trimmed) text after it
+ParsedNode classifyNode(std::string_view nodeTypeStr, std::string_view rest, int lineNumber);
+
+// Reads a text AST (a --dump-ast file) back into an AST. Nothing in uctool calls it since the
+// semantic stages take the parse tree in memory (buildAST below); it is kept for tooling and
+// debugging, and for the benchmark that checks buildAST against it.
+AST readASTFromFile(const std::string& filename);
+// Lowers the parser's tree (parser_utils.hpp) to the semantic AST in memory, filling each node from
+// the parse node's fields. The result is the tree readASTFromFile reads back from the dump of the
+// same parse, line numbers included (bench/ast_reader_bench.cpp checks this), except that a
+// declaration whose initializer holds a newline keeps its plain type: the dump quotes that whole
+// line, and the reader takes the quote into the type. shareExpressions hash-conses repeated
+// expressions (AST::Builder); only semantic analysis uses it, TAC is built from unshared trees.
+AST buildAST(const ProgramNode& program, bool shareExpressions = false);
\ No newline at end of file
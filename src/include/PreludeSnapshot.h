@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+struct FrontendContext;
+
+// Precompiled prelude (--pch). The prelude is the run of directives a source file starts with, together
+// with the header tokens its #includes splice in. A snapshot holds the lexer state right after it: the
+// prelude's tokens and their spellings, the macro table, the included-file list, the open conditionals,
+// and for each header its path, size, modification time, guard and line starts.
+// The file is versioned binary and is read through a mapping (MappedFile), with spellings borrowed
+// from it. It carries no source path, so translation units whose prelude has the same text, in the
+// same directory, share it. Struct and function symbols are not stored: the semantic stage rebuilds
+// them from the AST, and the declarations they come from are among the snapshot's tokens.
+
+// Restores ctx from ctx.pch_path when the snapshot matches the file being lexed: the same prelude
+// bytes, the same directory and include path, and every header unchanged on disk. On success,
+// resume is the offset to go on scanning from.
+bool loadPreludeSnapshot(FrontendContext& ctx, uint32_t& resume);
+
+// Writes the prelude of a file just lexed from scratch to ctx.pch_path (via a temporary file and a
+// rename, so a concurrent reader never sees half of it). Nothing is written for a file without one.
+bool savePreludeSnapshot(const FrontendContext& ctx);
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+
+// Run-length kernels for the scanner's long runs over an in-memory buffer [p, end).
+// Each "skip" returns the first byte that does not belong to the run (end if none);
+// the "find" functions return nullptr when the construct is unterminated.
+struct ScanKernels {
+    const char* name;
+
+    // [ \t\r\n]*
+    const char* (*skipBlanks)(const char* p, const char* end);
+    // [A-Za-z0-9_]*
+    const char* (*skipIdentifier)(const char* p, const char* end);
+    // First occurrence of c, or end
+    const char* (*findByte)(const char* p, const char* end, char c);
+    // Just past the first "*/" (p is the first byte after "/*")
+    const char* (*findCommentEnd)(const char* p, const char* end);
+    // Just past the closing quote of a literal body matching (\\.|[^\\"])* (p is after the opening quote)
+    const char* (*findStringEnd)(const char* p, const char* end, char quote);
+    size_t (*countNewlines)(const char* p, const char* end);
+};
+
+// Best implementation for this CPU (AVX2, SSE2 or scalar), chosen on first use
+const ScanKernels& scanKernels();
+
+// Portable byte-at-a-time versions, also the reference the SIMD ones are checked against
+const ScanKernels& scalarScanKernels();
+
+#if defined(__x86_64__) || defined(__i386__)
+const ScanKernels& sse2ScanKernels();
+const ScanKernels* avx2ScanKernels(); // nullptr when the CPU lacks AVX2
+#endif
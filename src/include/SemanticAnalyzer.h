@@ -5,68 +5,80 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 #include "SymbolTable.h"
 #include "TAC.h"
 #include "DAG.h"
 #include "AST.h"
+#include "ASTVisitor.h"
 
 class SemanticAnalyzer {
 private:
-    std::shared_ptr<ASTNode> ast;
+    AST ast;
     SymbolTable symbolTable;
     std::vector<TACInstruction> tacInstructions;
     std::vector<std::shared_ptr<DAGNode>> dagNodes;
-    std::vector<std::string> registers;
+    std::vector<Name> registers;
     std::vector<SemanticIssue> issues;
     int tempCounter;
     int labelCounter;
     int dagNodeCounter;
     size_t registerCounter;
-    std::string currentFunctionReturnType;
-    std::map<std::string, std::vector<std::vector<std::string>>> functionSignatures;
+    Name currentFunctionReturnType;
+    std::unordered_map<Name, std::vector<std::vector<Name>>> functionSignatures;
     std::map<std::string, std::string> variableInitialValues;
-    std::vector<std::string> loopLabels;
+    std::vector<Name> loopLabels;
+    ASTWalkStack walkStack;             // Shared by the passes below (ASTVisitor.h)
+    std::vector<Name> expressionValues; // Types or TAC operands of the expressions being walked
+    std::vector<Name> openLabels;       // Labels of the While and IfElse nodes generateTAC is inside
 
-    std::string newTemp();
-    std::string newLabel();
-    std::string allocateRegister();
-    void freeRegister(const std::string& reg);
-    std::shared_ptr<DAGNode> findDAGNode(const std::string& op, const std::string& arg1, const std::string& arg2);
-    std::shared_ptr<DAGNode> createDAGNode(const std::string& op, const std::string& value,
-                                           const std::vector<std::string>& args, int line);
-    void analyzeNode(const std::shared_ptr<ASTNode>& node);
-    void analyzeFunction(const std::shared_ptr<ASTNode>& node);
-    void analyzeForLoop(const std::shared_ptr<ASTNode>& node);
-    void analyzeWhileLoop(const std::shared_ptr<ASTNode>& node);
-    void analyzeIfElse(const std::shared_ptr<ASTNode>& node);
-    void analyzeVarDecl(const std::shared_ptr<ASTNode>& node);
-    void analyzeAssignment(const std::shared_ptr<ASTNode>& node);
-    void analyzeCompoundAssign(const std::shared_ptr<ASTNode>& node);
-    void analyzeFunctionCall(const std::shared_ptr<ASTNode>& node);
-    void analyzeReturn(const std::shared_ptr<ASTNode>& node);
-    std::string getExpressionType(const std::shared_ptr<ASTNode>& node);
-    bool isCompatibleType(const std::string& type1, const std::string& type2);
-    bool validateBinaryOperation(const std::string& op, const std::string& type1, const std::string& type2);
-    std::string generateExpressionTAC(const std::shared_ptr<ASTNode>& node);
-    void generateTAC(const std::shared_ptr<ASTNode>& node);
-    void generateForLoopTAC(const std::shared_ptr<ASTNode>& node);
-    void generateIfElseTAC(const std::shared_ptr<ASTNode>& node);
-    void generateFunctionTAC(const std::shared_ptr<ASTNode>& node);
-    void generateCompoundAssignTAC(const std::shared_ptr<ASTNode>& node);
+    Name newTemp();
+    Name newLabel();
+    Name allocateRegister();
+    void freeRegister(Name reg);
+    std::shared_ptr<DAGNode> findDAGNode(Name op, Name arg1, Name arg2);
+    std::shared_ptr<DAGNode> createDAGNode(Name op, Name value,
+                                           const std::vector<Name>& args, int line);
+    Name takeExpressionValue();
+    void analyzeNode(ASTRef node);
+    void analyzeForLoop(ASTRef node);
+    void analyzeWhileLoop(ASTRef node);
+    void analyzeIfElse(ASTRef node);
+    void analyzeVarDecl(ASTRef node);
+    void analyzeAssignment(ASTRef node);
+    void analyzeCompoundAssign(ASTRef node);
+    void analyzeFunctionCall(ASTRef node);
+    void analyzeReturn(ASTRef node);
+    Name getExpressionType(ASTRef node);
+    bool isCompatibleType(Name type1, Name type2);
+    bool validateBinaryOperation(Name op, Name type1, Name type2);
+    Name generateExpressionTAC(ASTRef node);
+    void generateTAC(ASTRef node);
+    void generateForLoopTAC(ASTRef node);
+    void generateIfElseTAC(ASTRef node);
+    void generateFunctionTAC(ASTRef node);
+    void generateCompoundAssignTAC(ASTRef node);
     void printTAC() const;
     void generateTargetCode();
-    void generateFunctionPrologue(const std::string& funcName);
+    void generateFunctionPrologue(Name funcName);
     void generateFunctionEpilogue();
-    void generateLoopCode(const std::shared_ptr<ASTNode>& node);
-    void printAST(const std::shared_ptr<ASTNode>& node, std::ofstream& out, int indent = 0) const;
+    void generateLoopCode(ASTRef node);
+    void printAST(ASTRef node, std::ofstream& out, int indent = 0) const;
+
+    // What analyzeNode, getExpressionType, generateExpressionTAC and generateTAC do at each node
+    // they walk; step is the node's ASTVisitor step
+    void analyzeStep(ASTWalk& walk, ASTRef node, uint32_t step);
+    void expressionTypeStep(ASTWalk& walk, ASTRef node, uint32_t step);
+    void expressionTACStep(ASTWalk& walk, ASTRef node, uint32_t step);
+    void generateTACStep(ASTWalk& walk, ASTRef node, uint32_t step);
 
 public:
-    SemanticAnalyzer(std::shared_ptr<ASTNode> a);
+    SemanticAnalyzer(AST a);
     void analyzeSemantics();
     void generateTACOnly();
     void generateTargetCodeOnly();
-    void saveASTToFile(const std::string& filename) const;
+    void saveASTToFile(const std::string& filename);
     const std::vector<SemanticIssue>& getIssues() const;
 };
 
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Counters for --stats; a hit is an intern call that found the text already pooled
+struct StringPoolStats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t bytesRequested = 0; // Total length of every text passed to intern
+    uint64_t bytesStored = 0;    // Bytes copied into the arena (one copy per distinct spelling)
+    uint64_t bytesBorrowed = 0;  // Distinct spellings kept as views into a caller-owned buffer
+    size_t arenaBytes = 0;       // Arena capacity currently reserved
+};
+
+// One pool per compilation: every identifier, type name and operand spelling is stored once and
+// named by a dense 32-bit id. Copied text lives in an arena of fixed-size chunks, so views handed
+// out stay valid until clear(); borrowed text must outlive the pool (e.g. the mapped source file).
+class StringPool {
+private:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::vector<std::unique_ptr<char[]>> oversized;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+    std::vector<std::string_view> spellings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    StringPoolStats counters;
+
+    std::string_view store(std::string_view text);
+    uint32_t add(std::string_view text);
+
+public:
+    // Id of the empty string; it is never stored, so it means the same thing in every pool
+    static constexpr uint32_t kEmptyId = UINT32_MAX;
+
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    uint32_t intern(std::string_view text);
+    // Like intern(), but a new spelling is kept as a view into text's storage instead of a copy
+    uint32_t intern_borrowed(std::string_view text);
+
+    std::string_view view(uint32_t id) const {
+        return id == kEmptyId ? std::string_view() : spellings[id];
+    }
+    size_t size() const { return spellings.size(); }
+    const StringPoolStats& stats() const { return counters; }
+    void printStats(std::ostream& os) const;
+    void clear();
+
+    // The pool Name handles resolve against on this thread; a compilation activates its own
+    static StringPool& current();
+
+    class Scope {
+    private:
+        StringPool* previous;
+    public:
+        explicit Scope(StringPool& pool);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+// Interned name: a 32-bit id in the current StringPool. Equality is an id compare;
+// the text is only looked up when a name is printed or taken apart.
+class Name {
+private:
+    uint32_t index = StringPool::kEmptyId;
+
+public:
+    Name() = default;
+    Name(std::string_view text) : index(StringPool::current().intern(text)) {}
+    Name(const std::string& text) : Name(std::string_view(text)) {}
+    Name(const char* text) : Name(std::string_view(text)) {}
+
+    static Name fromId(uint32_t id) {
+        Name name;
+        name.index = id;
+        return name;
+    }
+
+    uint32_t id() const { return index; }
+    bool empty() const { return index == StringPool::kEmptyId; }
+    std::string_view view() const { return StringPool::current().view(index); }
+    std::string str() const { return std::string(view()); }
+    size_t length() const { return view().length(); }
+
+    friend bool operator==(Name a, Name b) { return a.index == b.index; }
+    friend bool operator!=(Name a, Name b) { return a.index != b.index; }
+    // Comparing against plain text does not intern it
+    friend bool operator==(Name a, std::string_view b) { return a.view() == b; }
+    friend bool operator!=(Name a, std::string_view b) { return a.view() != b; }
+    friend bool operator==(Name a, const char* b) { return a.view() == b; }
+    friend bool operator!=(Name a, const char* b) { return a.view() != b; }
+    friend bool operator==(Name a, const std::string& b) { return a.view() == b; }
+    friend bool operator!=(Name a, const std::string& b) { return a.view() != b; }
+};
+
+inline std::string operator+(const std::string& a, Name b) { return a + std::string(b.view()); }
+inline std::string operator+(std::string&& a, Name b) { return std::move(a.append(b.view())); }
+inline std::string operator+(const char* a, Name b) { return a + std::string(b.view()); }
+inline std::string operator+(Name a, const std::string& b) { return std::string(a.view()) + b; }
+inline std::string operator+(Name a, const char* b) { return std::string(a.view()) + b; }
+inline std::string& operator+=(std::string& a, Name b) { return a.append(b.view()); }
+inline std::ostream& operator<<(std::ostream& os, Name name) { return os << name.view(); }
+
+namespace std {
+template <>
+struct hash<Name> {
+    size_t operator()(Name name) const noexcept { return std::hash<uint32_t>()(name.id()); }
+};
+}
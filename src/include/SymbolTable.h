@@ -3,26 +3,27 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <algorithm>
-#include <numeric>
+#include <cstdint>
+#include "StringPool.h"
 
 struct Symbol {
-    std::string type;
-    std::string scope;
+    Name type;
+    Name scope;
     std::string attributes;
     bool initialized;
     bool used;
     int line;
-    std::vector<std::string> paramTypes;  // For function parameters
-    std::string returnType;               // For function return type
+    std::vector<Name> paramTypes;         // For function parameters
+    Name returnType;                      // For function return type
     std::string initialValue;             // For initialized variables
     bool isFunction;                      // To distinguish between variables and functions
 
     Symbol();
-    Symbol(const std::string& t, const std::string& s, const std::string& a, int l);
-    Symbol(const std::string& t, const std::string& s, const std::string& a, int l,
-           const std::vector<std::string>& params, const std::string& ret);
+    Symbol(Name t, Name s, const std::string& a, int l);
+    Symbol(Name t, Name s, const std::string& a, int l,
+           const std::vector<Name>& params, Name ret);
 };
 
 struct TypeCheck {
@@ -49,40 +50,82 @@ struct SemanticIssue {
     SemanticIssue(const std::string& t, const std::string& desc, const std::string& stat);
 };
 
+// Keyed by interned name, so a probe hashes and compares 32-bit ids instead of strings
+using SymbolMap = std::unordered_map<Name, Symbol>;
+
+// A variable in scope, and the declaration of the same name it hides
+struct ScopedSymbol {
+    Name name;
+    uint32_t shadowed;  // Index in SymbolTable::declared, or SymbolTable::kNoEntry
+    Symbol symbol;
+};
+
+// Variables in every open scope live in one array in declaration order, so the innermost scope's
+// are always at its end: exitScope() pops them and puts back whatever each one hid, touching only
+// that scope's symbols. An open-addressed table keyed by name id holds, for each name, the
+// innermost variable and any function, macro or struct, so a lookup is one probe however deep
+// the nesting.
 class SymbolTable {
+public:
+    static constexpr uint32_t kNoEntry = UINT32_MAX;
+
 private:
-    std::vector<std::map<std::string, Symbol>> scopes;  // Stack of scopes for variables
-    std::vector<std::string> scopeNames;
-    std::map<std::string, Symbol> macros;
-    std::map<std::string, Symbol> structs;
-    std::map<std::string, Symbol> functions;
+    struct NameSlot {
+        uint32_t name = kFreeSlot;
+        uint32_t innermost = kNoEntry;  // Index in declared
+        Symbol* function = nullptr;
+        Symbol* macro = nullptr;
+        Symbol* structure = nullptr;
+    };
+    // No pool hands out this id: it would take four billion spellings
+    static constexpr uint32_t kFreeSlot = StringPool::kEmptyId - 1;
+
+    std::vector<NameSlot> slots;  // Size is a power of two; kept at most half full
+    size_t slotsInUse;
+    std::vector<ScopedSymbol> declared;
+    std::vector<size_t> scopeStarts;  // Where each open scope's symbols begin in declared
+    std::vector<Name> scopeNames;
+    SymbolMap macros;
+    SymbolMap structs;
+    SymbolMap functions;
     std::vector<TypeCheck> typeChecks;
     std::vector<ScopeCheck> scopeChecks;
     std::vector<SemanticIssue> issues;
     bool hasStdioInclude;
-    std::string currentFunction;
+    Name currentFunction;
+
+    const NameSlot* find(Name name) const;
+    NameSlot* find(Name name);
+    NameSlot& slotFor(Name name);
+    void grow();
+    // Symbols of the index-th open scope, by name
+    std::vector<const ScopedSymbol*> scopeSymbols(size_t index) const;
+    bool declaredInCurrentScope(Name name) const;
+    void push(Name name, const Symbol& symbol);
 
 public:
     SymbolTable();
-    void enterScope(const std::string& scopeName);
+    void enterScope(Name scopeName);
     void exitScope();
-    bool declare(const std::string& name, const std::string& type, const std::string& attributes, int line);
-    bool declareWithInit(const std::string& name, const std::string& type, const std::string& value, int line);
-    bool defineMacro(const std::string& name, const std::string& value, int line);
-    bool defineStruct(const std::string& name, int line);
-    bool defineFunction(const std::string& name, const std::string& type, const std::vector<std::string>& params, int line);
-    const Symbol* lookup(const std::string& name, int line) const;
-    void markUsed(const std::string& name);
+    bool declare(Name name, Name type, const std::string& attributes, int line);
+    bool declareWithInit(Name name, Name type, const std::string& value, int line);
+    bool defineMacro(Name name, const std::string& value, int line);
+    bool defineStruct(Name name, int line);
+    bool defineFunction(Name name, Name type, const std::vector<Name>& params, int line);
+    // The innermost variable named name, else the function, macro or struct; valid until the
+    // next declaration
+    const Symbol* lookup(Name name, int line) const;
+    void markUsed(Name name);
     void setStdioInclude();
     bool hasStdio() const;
     void addTypeCheck(const std::string& location, const std::string& description, const std::string& status);
     void addWarning(const std::string& description, int line);
     void checkUnusedSymbols();
-    bool validateFunctionCall(const std::string& name, const std::vector<std::string>& argTypes, int line);
-    bool validateReturnType(const std::string& type, int line);
-    void enterFunction(const std::string& name);
+    bool validateFunctionCall(Name name, const std::vector<Name>& argTypes, int line);
+    bool validateReturnType(Name type, int line);
+    void enterFunction(Name name);
     void exitFunction();
-    void validateDeclaration(const std::string& name, const std::string& type, int line);
+    void validateDeclaration(Name name, Name type, int line);
     void printSymbolTable() const;
     void printTypeChecks() const;
     void printScopeChecks() const;
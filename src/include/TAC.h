@@ -3,18 +3,19 @@
 
 #include <string>
 #include <vector>
+#include "StringPool.h"
 
 struct TACInstruction {
-    std::string label;
-    std::string op;
-    std::string arg1;
-    std::string arg2;
-    std::string result;
+    Name label;
+    Name op;
+    Name arg1;
+    Name arg2;
+    Name result;
     int line;
     std::string comment;
 
-    TACInstruction(std::string l = "", std::string o = "", std::string a1 = "", 
-                  std::string a2 = "", std::string r = "", int ln = 0, std::string c = "")
+    TACInstruction(Name l = Name(), Name o = Name(), Name a1 = Name(), 
+                  Name a2 = Name(), Name r = Name(), int ln = 0, std::string c = "")
         : label(l), op(o), arg1(a1), arg2(a2), result(r), line(ln), comment(c) {}
 };
 
@@ -26,10 +27,10 @@ private:
 
 public:
     TACGenerator();
-    std::string newTemp();
-    std::string newLabel();
-    void addInstruction(std::string op, std::string arg1 = "", std::string arg2 = "", 
-                       std::string result = "", int line = 0, std::string comment = "");
+    Name newTemp();
+    Name newLabel();
+    void addInstruction(Name op, Name arg1 = Name(), Name arg2 = Name(), 
+                       Name result = Name(), int line = 0, std::string comment = "");
     const std::vector<TACInstruction>& getInstructions() const;
     void printInstructions() const;
     void optimizeCode();  // Basic optimization
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "token_iterator.hpp"
+#include "token_stream.hpp"
+
+struct FrontendContext;
+
+// A token as it crosses to the parser thread. The spelling is resolved by the lexer thread, so the
+// parser never reads the string pool while it is still growing; it points into the pool's arena or
+// the mapped source, which stay put.
+struct PipelinedToken {
+    Tokens token;
+    uint32_t line = 0;     // For an unknown token, its line (the parser reports it); 0 otherwise
+    std::string_view text;
+};
+
+// Lock-free ring between exactly one producer thread and one consumer thread. Positions only grow;
+// each side caches the other's position and rereads it only when the ring looks full or empty, so
+// in the steady state a push or a pop touches no shared cache line but its own.
+class SpscTokenRing {
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<PipelinedToken> slots;
+    size_t mask;
+    alignas(kCacheLine) std::atomic<size_t> head{0}; // Next slot to pop; written by the consumer
+    size_t cachedTail = 0;                           // Consumer's last look at tail
+    alignas(kCacheLine) std::atomic<size_t> tail{0}; // Next slot to fill; written by the producer
+    size_t cachedHead = 0;                           // Producer's last look at head
+
+public:
+    static constexpr size_t kDefaultCapacity = 1024; // 32 KiB of tokens
+
+    // capacity must be a power of two
+    explicit SpscTokenRing(size_t capacity = kDefaultCapacity) : slots(capacity), mask(capacity - 1) {}
+    SpscTokenRing(const SpscTokenRing&) = delete;
+    SpscTokenRing& operator=(const SpscTokenRing&) = delete;
+
+    // Producer side; false when the ring is full
+    bool tryPush(const PipelinedToken& token) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == slots.size()) {
+                return false;
+            }
+        }
+        slots[position & mask] = token;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the ring is empty
+    bool tryPop(PipelinedToken& token) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) {
+                return false;
+            }
+        }
+        token = slots[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// --pipeline: the scanner runs on a thread of its own and hands tokens to the parser through an
+// SpscTokenRing, so lexing and parsing overlap. The lexer thread owns ctx (its macros, string pool,
+// line index) until close(); the parser thread reads only the PipelinedTokens it pops, and writes
+// only ctx's parse arena and parse_result.
+class TokenPipeline {
+private:
+    FrontendContext& ctx;
+    TokenStream stream;
+    SpscTokenRing ring;
+    std::thread lexer;
+    std::atomic<bool> finished{false}; // Set after the last token is pushed
+    std::atomic<bool> stopping{false}; // The parser is done early; the lexer thread gives up
+    PipelinedToken current;
+    uint64_t producerWaits = 0;  // Times the lexer found the ring full (lexer thread)
+    uint64_t consumerWaits = 0;  // Times the parser found the ring empty (parser thread)
+
+    void produce();
+
+public:
+    explicit TokenPipeline(FrontendContext& context);
+    ~TokenPipeline() { close(); }
+    TokenPipeline(const TokenPipeline&) = delete;
+    TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+    // Opens filename on the calling thread, then starts the lexer thread
+    bool open(const char* filename);
+    // Stops and joins the lexer thread; ctx belongs to the caller again afterwards
+    void close();
+    // Next token in source order (unknown tokens included, in place); nullptr at end of input.
+    // Parser thread only.
+    const PipelinedToken* next();
+};
+
+// Runs the bison push parser over the pipeline's tokens (parser.y); returns what yyparse() would
+int pipelinedParse(FrontendContext* context, TokenPipeline& pipeline);
@@ -0,0 +1,116 @@
+#ifndef FRONTEND_CONTEXT_HPP
+#define FRONTEND_CONTEXT_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "token_iterator.hpp" // For Tokens, UnknownTokens, TokenIterator
+#include "token_stream.hpp"   // For TokenRing, TokenStream
+#include "parser_utils.hpp"   // For ProgramNode
+#include "ParseArena.h"
+#include "MappedFile.h"
+#include "LineIndex.h"
+#include "HeaderCache.h"
+
+// An #ifdef/#ifndef whose #endif has not been reached yet
+struct Conditional {
+    uint32_t offset;         // Of the opening directive, for diagnostics
+    bool taken;              // A branch has been (or is being) scanned; the rest are skipped
+    bool else_seen = false;
+};
+
+// Everything the scanner and parser mutate for one translation unit.
+// Each compilation owns its own context, so independent files can be lexed and parsed on separate threads.
+struct FrontendContext {
+    StringPool strings; // Every name in this compilation, from token text through to TAC operands
+    std::vector<Tokens> tokens;
+    std::vector<UnknownTokens> unknown_tokens;
+    std::unordered_map<std::string, std::string> macros;
+    std::vector<std::string> included_files;
+    std::vector<Conditional> conditions; // Open conditionals, innermost last
+    uint32_t skip_depth = 0;             // Conditionals opened inside the inactive region being skipped
+    uint32_t scan_offset = 0;  // Byte offset of the scanner's current match
+    uint32_t scan_limit = UINT32_MAX; // yylex() stops (ScanLimitReached) before a match starting here or later
+    bool tokens_ready = false; // Set once the scanner has filled tokens for the current file
+
+    // Whole source file in memory; strings may hold views into it, so it lives as long as they do
+    std::string source_path;
+    MappedFile source;
+    bool map_source = true;         // Scan the file in place (mmap) instead of through stdio
+    bool source_in_memory = false;  // Set while the scanner runs over source
+    bool use_scan_kernels = true;   // With the source in memory, let SIMD kernels skip long runs (ScanKernels.h)
+    bool borrow_lexemes = true;     // With the source in memory, pool token text as views into it (off when it gets edited)
+    std::string pch_path;           // --pch: prelude snapshot to start from, or to write after a full lex (PreludeSnapshot.h)
+    MappedFile snapshot;            // The snapshot in use; strings may hold views into it as well
+    bool expand_macros = true;      // Replace defined names as they are scanned (off when lexing a header for HeaderCache)
+
+    // #include "..." expansion (HeaderCache.h)
+    bool expand_includes = true;            // Splice quoted headers in after their directive token
+    std::vector<std::string> include_dirs;  // Searched after the including file's own directory (-I)
+    std::vector<std::shared_ptr<const HeaderEntry>> include_sources;  // Headers spliced in; Tokens::file n is entry n - 1
+    std::unordered_map<std::string, std::string> include_guards;      // Guard macro of each guarded header seen, by path
+
+    // Parallel lexing of one large mapped file (ParallelLexer.h)
+    unsigned lex_jobs = 0;     // Worker threads; 0 = one per core, 1 = always lex serially
+    bool speculative = false;  // Scanning a chunk on the guess that it starts between tokens
+    bool scan_hazard = false;  // The guess may be wrong: something ran open to the chunk end, or a diagnostic was held back
+
+    // Streaming mode (--stream): tokens pass through a bounded ring instead of accumulating in tokens
+    bool stream_tokens = false;
+    bool pipeline_tokens = false; // --pipeline: lex on a second thread while the parser consumes (TokenPipeline.h)
+    TokenRing token_ring;
+    TokenStream* token_stream = nullptr; // Set while a stream is open; the scanner then emits into token_ring
+
+    TokenIterator* token_iterator = nullptr;
+    ParseArena parse_arena;              // Owns parse_result and every node under it
+    ProgramNode* parse_result = nullptr; // Kept until the next parse; the later stages lower it with buildAST (Parser.h)
+    std::string parse_tree_text;         // Text dump of parse_result once something asked for it
+    bool dump_ast = false;               // --dump-ast: also write the tree to temp/parser-output.ast
+
+    mutable LineIndex lines; // Filled on demand by position()
+
+    void emit_token(const Tokens& token) {
+        if (token_stream != nullptr) {
+            token_ring.push(token);
+        } else {
+            tokens.push_back(token);
+        }
+    }
+
+    // Unknown tokens stay in source order when streamed; otherwise they are collected apart
+    void emit_unknown_token(const UnknownTokens& token) {
+        if (token_stream != nullptr) {
+            token_ring.push(Tokens{token.lexeme, token.offset, TokenKind::Unknown, 0, token.file});
+        } else {
+            unknown_tokens.push_back(token);
+        }
+    }
+
+    // Line/column of a source offset. The line index is built the first time a position is
+    // needed (a diagnostic or a table row), from the mapped source or else from the file itself.
+    SourcePosition position(uint32_t offset) const {
+        if (!lines.isBuilt()) {
+            if (source.isOpen()) {
+                lines.build(source.data(), source.data() + source.size());
+            } else {
+                lines.buildFromFile(source_path);
+            }
+        }
+        return lines.position(offset);
+    }
+
+    // Position of a token in whichever file it came from
+    SourcePosition position(uint16_t file, uint32_t offset) const {
+        return file == 0 ? position(offset) : include_sources[file - 1]->lines.position(offset);
+    }
+
+    FrontendContext() { seed_reserved_lexemes(strings); }
+    FrontendContext(const FrontendContext&) = delete;
+    FrontendContext& operator=(const FrontendContext&) = delete;
+    ~FrontendContext() {
+        delete token_iterator;
+    }
+};
+
+#endif // FRONTEND_CONTEXT_HPP
@@ -0,0 +1,141 @@
+#ifndef LEXEME_TABLE_HPP
+#define LEXEME_TABLE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+enum class TokenKind : uint8_t {
+    Preprocessor,
+    Keyword,
+    RelationalOperator,
+    Operator,
+    Punctuation,
+    Float,
+    Hex,
+    Octal,
+    Int,
+    Char,
+    String,
+    MacroExpansion,
+    Identifier,
+    Unknown
+};
+
+inline const char* token_kind_name(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::Preprocessor: return "Preprocessor";
+        case TokenKind::Keyword: return "Keyword";
+        case TokenKind::RelationalOperator: return "Relational Operator";
+        case TokenKind::Operator: return "Operator";
+        case TokenKind::Punctuation: return "Punctuation";
+        case TokenKind::Float: return "Float";
+        case TokenKind::Hex: return "Hex";
+        case TokenKind::Octal: return "Octal";
+        case TokenKind::Int: return "Int";
+        case TokenKind::Char: return "Char";
+        case TokenKind::String: return "String";
+        case TokenKind::MacroExpansion: return "Macro Expansion";
+        case TokenKind::Identifier: return "Identifier";
+        case TokenKind::Unknown: return "Unknown";
+    }
+    return "Unknown";
+}
+
+// Every fixed spelling: X(spelling, token kind, bison token).
+// The bison column is only expanded inside the parser, where the token names exist;
+// -1 marks spellings the grammar has no use for yet.
+#define UC_RESERVED_LEXEMES(X) \
+    X("#ifdef", Preprocessor, -1) X("#ifndef", Preprocessor, -1) X("#else", Preprocessor, -1) \
+    X("#endif", Preprocessor, -1) X("#undef", Preprocessor, -1) X("#pragma", Preprocessor, -1) \
+    X("auto", Keyword, -1) X("break", Keyword, -1) X("case", Keyword, -1) X("char", Keyword, -1) \
+    X("const", Keyword, -1) X("continue", Keyword, -1) X("default", Keyword, -1) X("do", Keyword, -1) \
+    X("double", Keyword, -1) X("else", Keyword, ELSE) X("enum", Keyword, -1) X("extern", Keyword, -1) \
+    X("float", Keyword, FLOAT) X("for", Keyword, FOR) X("goto", Keyword, -1) X("if", Keyword, IF) \
+    X("int", Keyword, INT) X("long", Keyword, -1) X("register", Keyword, -1) X("return", Keyword, RETURN) \
+    X("short", Keyword, -1) X("signed", Keyword, -1) X("sizeof", Keyword, -1) X("static", Keyword, -1) \
+    X("struct", Keyword, STRUCT) X("switch", Keyword, -1) X("typedef", Keyword, -1) X("union", Keyword, -1) \
+    X("unsigned", Keyword, -1) X("void", Keyword, VOID) X("volatile", Keyword, -1) X("while", Keyword, WHILE) \
+    X("==", RelationalOperator, EQ) X("!=", RelationalOperator, -1) X("<=", RelationalOperator, LE) \
+    X(">=", RelationalOperator, -1) X(">", RelationalOperator, GT) X("<", RelationalOperator, LT) \
+    X("=", Operator, ASSIGN) X("+", Operator, PLUS) X("-", Operator, MINUS) X("*", Operator, MULT) \
+    X("/", Operator, DIV) X("%", Operator, MOD) X("^", Operator, -1) X(".", Operator, -1) \
+    X("++", Operator, PLUSPLUS) X("--", Operator, -1) X("&&", Operator, -1) X("||", Operator, -1) \
+    X("&", Operator, ADDRESS) X("|", Operator, -1) X("~", Operator, -1) X("<<", Operator, -1) \
+    X(">>", Operator, -1) X("->", Operator, -1) X("+=", Operator, -1) X("-=", Operator, -1) \
+    X("*=", Operator, MULTEQ) X("/=", Operator, -1) X("%=", Operator, -1) X("&=", Operator, -1) \
+    X("^=", Operator, -1) X("|=", Operator, -1) X("<<=", Operator, -1) X(">>=", Operator, -1) \
+    X("(", Punctuation, LPAREN) X(")", Punctuation, RPAREN) X("{", Punctuation, LBRACE) \
+    X("}", Punctuation, RBRACE) X(";", Punctuation, SEMICOLON) X(",", Punctuation, COMMA) \
+    X("[", Punctuation, -1) X("]", Punctuation, -1) X(":", Punctuation, -1)
+
+#define UC_RESERVED_SPELLING(SPELLING, KIND, PARSER_TOKEN) SPELLING,
+#define UC_RESERVED_KIND(SPELLING, KIND, PARSER_TOKEN) TokenKind::KIND,
+
+// Fixed spellings are interned first, so their lexeme id is their index here
+inline constexpr std::string_view kReservedLexemes[] = { UC_RESERVED_LEXEMES(UC_RESERVED_SPELLING) };
+inline constexpr TokenKind kReservedKinds[] = { UC_RESERVED_LEXEMES(UC_RESERVED_KIND) };
+inline constexpr uint32_t kReservedLexemeCount = sizeof(kReservedLexemes) / sizeof(kReservedLexemes[0]);
+
+constexpr size_t longest_reserved_lexeme() {
+    size_t longest = 0;
+    for (std::string_view spelling : kReservedLexemes) {
+        if (spelling.size() > longest) longest = spelling.size();
+    }
+    return longest;
+}
+inline constexpr size_t kLongestReservedLexeme = longest_reserved_lexeme();
+
+// Perfect hash over the reserved spellings: a seeded FNV-1a (plus finalizer) whose seed is searched at
+// compile time until every spelling lands in its own slot of a 1024-entry table
+inline constexpr uint32_t kReservedHashBits = 10;
+
+constexpr uint32_t reserved_hash(std::string_view spelling, uint32_t seed) {
+    uint32_t hash = seed;
+    for (char c : spelling) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    // Finalizer so the one-byte operators spread over the top bits as well
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash >> (32 - kReservedHashBits);
+}
+
+struct ReservedHashTable {
+    uint32_t seed;
+    std::array<uint8_t, 1u << kReservedHashBits> slots; // Lexeme id + 1, 0 for an empty slot
+};
+
+constexpr ReservedHashTable build_reserved_hash_table() {
+    for (uint32_t seed = 2166136261u; seed < 2166136261u + 4096u; ++seed) {
+        ReservedHashTable table{seed, {}};
+        bool collision = false;
+        for (uint32_t id = 0; id < kReservedLexemeCount && !collision; ++id) {
+            uint8_t& slot = table.slots[reserved_hash(kReservedLexemes[id], seed)];
+            collision = slot != 0;
+            slot = static_cast<uint8_t>(id + 1);
+        }
+        if (!collision) return table;
+    }
+    return ReservedHashTable{0, {}};
+}
+
+static_assert(kReservedLexemeCount < 255, "Reserved lexeme ids must fit the uint8_t hash slots");
+inline constexpr ReservedHashTable kReservedHashTable = build_reserved_hash_table();
+static_assert(kReservedHashTable.seed != 0, "No perfect hash seed found for the reserved lexemes");
+
+// Lexeme id of a reserved spelling, kReservedLexemeCount otherwise: one hash, one compare
+constexpr uint32_t reserved_lexeme_id(std::string_view spelling) {
+    if (spelling.size() > kLongestReservedLexeme) {
+        return kReservedLexemeCount;
+    }
+    uint8_t slot = kReservedHashTable.slots[reserved_hash(spelling, kReservedHashTable.seed)];
+    return slot != 0 && kReservedLexemes[slot - 1] == spelling ? slot - 1u : kReservedLexemeCount;
+}
+
+static_assert(reserved_lexeme_id("while") < kReservedLexemeCount
+              && kReservedLexemes[reserved_lexeme_id("while")] == "while", "Perfect hash lookup is broken");
+static_assert(reserved_lexeme_id("whilst") == kReservedLexemeCount, "Perfect hash lookup is broken");
+
+#endif // LEXEME_TABLE_HPP
@@ -3,18 +3,36 @@
 
 #include <stdio.h>
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+struct FrontendContext;
 
-    int yylex(void);
-    int yyparse(void);
-    void yyerror(const char* msg);
+// Reentrant flex scanner (%option reentrant); all state hangs off the yyscan_t handle
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
 
-#ifdef __cplusplus
-}
+#ifndef YY_TYPEDEF_YY_BUFFER_STATE
+#define YY_TYPEDEF_YY_BUFFER_STATE
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
 #endif
 
-extern FILE* yyin;
+int yylex_init_extra(FrontendContext* context, yyscan_t* scanner);
+int yylex_destroy(yyscan_t scanner);
+void yyset_in(FILE* input_file, yyscan_t scanner);
+// base must end in two NUL bytes (size includes them); the scanner reads it in place
+YY_BUFFER_STATE yy_scan_buffer(char* base, size_t size, yyscan_t scanner);
+int yylex(yyscan_t scanner);
+
+// What yylex() returns: ScanEnd at the end of the input; otherwise it stopped early and resumes
+// where it left off when called again
+enum ScanResult {
+    ScanEnd = 0,
+    ScanRingFull = 1,     // The token ring of an open TokenStream is full
+    ScanLimitReached = 2  // The next match starts at or past FrontendContext::scan_limit, outside a directive
+};
+
+// Pure bison parser (api.pure full); reads tokens from context->token_iterator
+int yyparse(FrontendContext* context);
+void yyerror(FrontendContext* context, const char* msg);
 
 #endif // LEXER_H
\ No newline at end of file
@@ -2,33 +2,77 @@
 #define LEXER_UTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <utility>
 #include <iostream>
-#include "token_iterator.hpp" // For Tokens, UnknownTokens, TokenIterator
+#include "frontend_context.hpp"
 
-inline int col_num = 1;
-extern int line_num;
+inline void define_macro(FrontendContext& ctx, const std::string& name, const std::string& value) {
+    ctx.macros[name] = value;
+}
+
+// Records the directive; a quoted header is then expanded in place (filename keeps its quotes).
+// A speculative chunk scan (ParallelLexer.h) cannot know the macros a header's guard depends on,
+// so it marks the chunk for a serial re-lex instead.
+inline void include_file(FrontendContext& ctx, const std::string& filename, bool is_system) {
+    ctx.included_files.push_back(filename);
+    if (is_system || !ctx.expand_includes) {
+        return;
+    }
+    if (ctx.speculative) {
+        ctx.scan_hazard = true;
+        return;
+    }
+    expandInclude(ctx, filename.substr(1, filename.size() - 2), ctx.source_path);
+}
 
-inline std::vector<Tokens> tokens;
-inline std::vector<UnknownTokens> unknown_tokens;
-inline std::unordered_map<std::string, std::string> macros;
-inline std::vector<std::string> included_files;
+// Name and value of a "#define NAME VALUE" token's text; the value is empty for "#define NAME"
+inline std::pair<std::string_view, std::string_view> split_define(std::string_view text) {
+    text.remove_prefix(8); // "#define "
+    size_t space = text.find(' ');
+    if (space == std::string_view::npos) {
+        return {text, std::string_view()};
+    }
+    return {text.substr(0, space), text.substr(space + 1)};
+}
 
-inline void define_macro(const std::string& name, const std::string& value) {
-    macros[name] = value;
+// Replacement text for name, or nullptr when name is not a macro (the common case costs no allocation)
+inline const std::string* find_macro(const FrontendContext& ctx, std::string_view name) {
+    if (ctx.macros.empty()) {
+        return nullptr;
+    }
+    auto it = ctx.macros.find(std::string(name));
+    return it != ctx.macros.end() ? &it->second : nullptr;
 }
 
-inline void include_file(const std::string& filename, bool is_system) {
-    included_files.push_back(filename);
+// #ifdef NAME (if_defined) or #ifndef NAME: opens a conditional on open and says whether its
+// first branch is taken
+inline bool open_conditional(const FrontendContext& ctx, std::vector<Conditional>& open, std::string_view name,
+                             bool if_defined, uint32_t offset) {
+    bool taken = (find_macro(ctx, name) != nullptr) == if_defined;
+    open.push_back(Conditional{offset, taken});
+    return taken;
 }
 
-inline std::string expand_macro(const std::string& name) {
-    auto it = macros.find(name);
-    if (it != macros.end()) {
-        return it->second;
+// Conditionals of the compiled file still open after the tokens in [begin, end). Tokens only come
+// from active branches, so a scan that restarts there is inside a taken branch of each of them.
+inline std::vector<Conditional> open_conditionals_before(const Tokens* begin, const Tokens* end) {
+    std::vector<Conditional> open;
+    for (const Tokens* token = begin; token != end; ++token) {
+        if ((token->flags & TokenFlagConditional) == 0 || token->file != 0) {
+            continue;
+        }
+        if (token->lexeme == reserved_lexeme_id("#endif")) {
+            open.pop_back();
+        } else if (token->lexeme == reserved_lexeme_id("#else")) {
+            open.back().else_seen = true;
+        } else {
+            open.push_back(Conditional{token->offset, true});
+        }
     }
-    return name;
+    return open;
 }
 
 #endif // LEXER_UTILS_HPP
\ No newline at end of file
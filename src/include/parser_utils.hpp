@@ -1,150 +1,227 @@
 #ifndef PARSER_UTILS_HPP
 #define PARSER_UTILS_HPP
 
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
-class ASTNode {
-public:
-    std::string type;
-    std::string value;
-    std::vector<ASTNode*> children;
-
-    ASTNode(const std::string& t = "", const std::string& v = "") : type(t), value(v) {}
-    ~ASTNode() { for (auto* child : children) delete child; }
-
-    std::string to_string(int indent = 0) const {
-        std::string result = std::string(indent, ' ') + type;
-        if (!value.empty()) {
-            // Check for strings containing newlines
-            std::string display_value = value;
-            if (value.find('\n') != std::string::npos) {
-                // Remove quotes and replace newline with \n
-                if (display_value.front() == '"' && display_value.back() == '"') {
-                    display_value = display_value.substr(1, display_value.length() - 2);
-                }
-                size_t pos = 0;
-                while ((pos = display_value.find('\n', pos)) != std::string::npos) {
-                    display_value.replace(pos, 1, "\\n");
-                    pos += 2;
-                }
-                result += ": \"" + display_value + "\"";
-            } else if (value == "\"\\n\"") {
-                result += ": \"\\n\"";
-            } else {
-                result += ": " + value;
-            }
-        }
-        result += "\n";
-        for (const auto* child : children) {
-            result += child->to_string(indent + 2);
+// Parse tree built by the grammar. Every node lives in the parse's ParseArena (ParseArena.h) and
+// takes the arena's memory resource first, so its strings and lists allocate there too; nodes are
+// never deleted one by one, so they have no destructors. buildAST (Parser.h) lowers the tree to
+// the semantic AST (AST.h); write_parse_tree() writes the text dump, one node per line.
+
+class ParseNode;
+class StatementNode;
+class FunctionNode;
+
+using ExpressionList = std::pmr::vector<ParseNode*>;
+using StatementList = std::pmr::vector<StatementNode*>;
+using FunctionList = std::pmr::vector<FunctionNode*>;
+
+// Appends value as the text AST shows it after "Type: ": a string holding newlines is written with \n escapes
+inline void append_display_value(std::string& out, std::string_view value) {
+    if (value.find('\n') == std::string_view::npos) {
+        out += value;
+        return;
+    }
+    // Remove quotes and replace newline with \n
+    if (value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.length() - 2);
+    }
+    out += '"';
+    for (char c : value) {
+        if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
         }
-        return result;
     }
+    out += '"';
+}
+
+inline std::string display_value(std::string_view value) {
+    std::string shown;
+    append_display_value(shown, value);
+    return shown;
+}
+
+class ParseNode {
+public:
+    std::pmr::string type;
+    std::pmr::string value;
+    ExpressionList children;
+
+    explicit ParseNode(std::pmr::memory_resource* memory, std::string_view t = "", std::string_view v = "")
+        : type(t, memory), value(v, memory), children(memory) {}
 };
 
 class StatementNode {
 public:
-    std::string type;
-    std::string value;
-    std::vector<StatementNode*> statements;
-    std::vector<ASTNode*> children;
-
-    StatementNode() : type("Statement") {}
-    ~StatementNode() {
-        for (auto* stmt : statements) delete stmt;
-        for (auto* child : children) delete child;
-    }
+    std::pmr::string type;
+    std::pmr::string value;
+    // Parts of value the semantic AST keeps apart: what a call, declaration or assignment names,
+    // and the type a declaration gives it
+    std::pmr::string name;
+    std::pmr::string type_hint;
+    StatementList statements;
+    ExpressionList children;
+
+    explicit StatementNode(std::pmr::memory_resource* memory)
+        : type("Statement", memory), value(memory), name(memory), type_hint(memory), statements(memory), children(memory) {}
 
-    std::string to_string(int indent = 0) const {
-        std::string result = std::string(indent, ' ') + type;
-        if (!value.empty()) {
-            // Check for strings containing newlines
-            std::string display_value = value;
-            if (value.find('\n') != std::string::npos) {
-                // Remove quotes and replace newline with \n
-                if (display_value.front() == '"' && display_value.back() == '"') {
-                    display_value = display_value.substr(1, display_value.length() - 2);
-                }
-                size_t pos = 0;
-                while ((pos = display_value.find('\n', pos)) != std::string::npos) {
-                    display_value.replace(pos, 1, "\\n");
-                    pos += 2;
-                }
-                result += ": \"" + display_value + "\"";
-            } else if (value == "\"\\n\"") {
-                result += ": \"\\n\"";
-            } else {
-                // Handle Call nodes specifically
-                if (type == "Call" && !children.empty()) {
-                    // Extract function name from value (before parentheses)
-                    size_t paren_pos = value.find('(');
-                    std::string func_name = (paren_pos != std::string::npos) ? value.substr(0, paren_pos) : value;
-                    result = std::string(indent, ' ') + type + ": " + func_name;
-                    // Reconstruct arguments without quotes around the entire call
-                    if (paren_pos != std::string::npos) {
-                        std::string args = value.substr(paren_pos);
-                        size_t pos = 0;
-                        while ((pos = args.find('\n', pos)) != std::string::npos) {
-                            args.replace(pos, 1, "\\n");
-                            pos += 2;
-                        }
-                        result += args;
-                    }
-                } else {
-                    result += ": " + value;
-                }
+    // Appends the dump's text after "Type: "
+    void append_shown_value(std::string& out) const {
+        if (type == "Call" && !children.empty() && value.find('\n') == std::string::npos && value != "\"\\n\"") {
+            // Handle Call nodes specifically: the function name, then the arguments without
+            // quotes around the entire call
+            std::string_view call = value;
+            size_t paren_pos = call.find('(');
+            out += call.substr(0, paren_pos);
+            if (paren_pos != std::string_view::npos) {
+                // No newline here, so the arguments go out as they are
+                out += call.substr(paren_pos);
             }
+            return;
         }
-        result += "\n";
-        for (const auto* stmt : statements) {
-            result += stmt->to_string(indent + 2);
-        }
-        for (const auto* child : children) {
-            result += child->to_string(indent + 2);
-        }
-        return result;
+        append_display_value(out, value);
+    }
+
+    std::string shown_value() const {
+        std::string shown;
+        append_shown_value(shown);
+        return shown;
     }
 };
 
 class FunctionNode {
 public:
-    std::string return_type;
-    std::string name;
-    std::vector<StatementNode*> statements;
-
-    FunctionNode() : return_type("void") {}
-    ~FunctionNode() { for (auto* stmt : statements) delete stmt; }
+    std::pmr::string return_type;
+    std::pmr::string name;
+    StatementList statements;
 
-    std::string to_string(int indent = 0) const {
-        std::string result = std::string(indent, ' ') + "Function: " + name + " (" + return_type + ")\n";
-        for (const auto* stmt : statements) {
-            result += stmt->to_string(indent + 2);
-        }
-        return result;
-    }
+    explicit FunctionNode(std::pmr::memory_resource* memory)
+        : return_type("void", memory), name(memory), statements(memory) {}
 };
 
 class ProgramNode {
 public:
-    std::vector<FunctionNode*> functions;
-    std::vector<ASTNode*> children;
+    FunctionList functions;
+    ExpressionList children;
 
-    ~ProgramNode() {
-        for (auto* func : functions) delete func;
-        for (auto* child : children) delete child;
+    explicit ProgramNode(std::pmr::memory_resource* memory) : functions(memory), children(memory) {}
+
+    // The text dump; write_parse_tree appends it to a buffer of the caller's instead
+    std::string to_string() const;
+};
+
+// Visits every node under program in dump order (each node, then its nested statements, then its
+// other children), calling visitor.visit(node, depth). Uses an explicit stack, so a deep tree costs
+// heap, not call stack.
+template <typename Visitor>
+void walk_parse_tree(const ProgramNode& program, Visitor& visitor) {
+    enum class Kind : uint8_t { Program, Function, Statement, Expression };
+    struct Pending {
+        const void* node;
+        Kind kind;
+        int depth;
+    };
+    std::vector<Pending> stack;
+    // Pushed last to first, so they pop in order
+    auto push = [&stack](const auto& list, Kind kind, int depth) {
+        for (auto it = list.rbegin(); it != list.rend(); ++it) {
+            stack.push_back(Pending{*it, kind, depth});
+        }
+    };
+
+    stack.push_back(Pending{&program, Kind::Program, 0});
+    while (!stack.empty()) {
+        Pending next = stack.back();
+        stack.pop_back();
+        switch (next.kind) {
+            case Kind::Program: {
+                const auto& node = *static_cast<const ProgramNode*>(next.node);
+                visitor.visit(node, next.depth);
+                push(node.children, Kind::Expression, next.depth + 1);
+                push(node.functions, Kind::Function, next.depth + 1);
+                break;
+            }
+            case Kind::Function: {
+                const auto& node = *static_cast<const FunctionNode*>(next.node);
+                visitor.visit(node, next.depth);
+                push(node.statements, Kind::Statement, next.depth + 1);
+                break;
+            }
+            case Kind::Statement: {
+                const auto& node = *static_cast<const StatementNode*>(next.node);
+                visitor.visit(node, next.depth);
+                push(node.children, Kind::Expression, next.depth + 1);
+                push(node.statements, Kind::Statement, next.depth + 1);
+                break;
+            }
+            case Kind::Expression: {
+                const auto& node = *static_cast<const ParseNode*>(next.node);
+                visitor.visit(node, next.depth);
+                push(node.children, Kind::Expression, next.depth + 1);
+                break;
+            }
+        }
     }
+}
 
-    std::string to_string(int indent = 0) const {
-        std::string result = std::string(indent, ' ') + "Program\n";
-        for (const auto* func : functions) {
-            result += func->to_string(indent + 2);
+// Writes the text dump, one line per node indented two spaces per level, by appending to a single
+// buffer: each byte is written once, whatever the depth
+class ParseTreeWriter {
+private:
+    std::string& out;
+
+    void begin(int depth, std::string_view type) {
+        out.append(size_t(depth) * 2, ' ');
+        out += type;
+    }
+
+public:
+    explicit ParseTreeWriter(std::string& buffer) : out(buffer) {}
+
+    void visit(const ProgramNode&, int depth) {
+        begin(depth, "Program");
+        out += '\n';
+    }
+    void visit(const FunctionNode& func, int depth) {
+        begin(depth, "Function: ");
+        out += func.name;
+        out += " (";
+        out += func.return_type;
+        out += ")\n";
+    }
+    void visit(const StatementNode& stmt, int depth) {
+        begin(depth, stmt.type);
+        if (!stmt.value.empty()) {
+            out += ": ";
+            stmt.append_shown_value(out);
         }
-        for (const auto* child : children) {
-            result += child->to_string(indent + 2);
+        out += '\n';
+    }
+    void visit(const ParseNode& expr, int depth) {
+        begin(depth, expr.type);
+        if (!expr.value.empty()) {
+            out += ": ";
+            append_display_value(out, expr.value);
         }
-        return result;
+        out += '\n';
     }
 };
 
+inline void write_parse_tree(std::string& out, const ProgramNode& program) {
+    ParseTreeWriter writer(out);
+    walk_parse_tree(program, writer);
+}
+
+inline std::string ProgramNode::to_string() const {
+    std::string text;
+    write_parse_tree(text, *this);
+    return text;
+}
+
 #endif // PARSER_UTILS_HPP
\ No newline at end of file
@@ -1,26 +1,49 @@
 #ifndef TOKEN_ITERATOR_HPP
 #define TOKEN_ITERATOR_HPP
 
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include <vector>
+#include "lexeme_table.hpp"
+#include "StringPool.h"
 
+// Fixed spellings go into an empty pool first, so their ids match kReservedLexemes
+inline void seed_reserved_lexemes(StringPool& pool) {
+    for (std::string_view spelling : kReservedLexemes) {
+        pool.intern(spelling);
+    }
+}
+
+// Classification made at lex time, so consumers never re-parse a token's text
+enum TokenFlag : uint8_t {
+    TokenFlagInclude = 1 << 0,        // #include "..." or #include <...>
+    TokenFlagSystemInclude = 1 << 1,  // The <...> form
+    TokenFlagDefine = 1 << 2,         // #define NAME VALUE (or #define NAME, with no value)
+    TokenFlagConditional = 1 << 3     // #ifdef NAME, #ifndef NAME, #else or #endif, already evaluated
+};
+
+// 12 bytes per token: the text lives once in the compilation's string pool, and the
+// line/column are looked up from the byte offset only when something prints them
 struct Tokens {
-    std::string type;
-    std::string value;
-    int line_no;
-    int col_no;
+    uint32_t lexeme;
+    uint32_t offset; // Byte offset of the token in the source file
+    TokenKind kind;
+    uint8_t flags = 0;
+    uint16_t file = 0; // 0 for the file being compiled, n for FrontendContext::include_sources[n - 1]
 };
+static_assert(sizeof(Tokens) == 12, "Tokens should stay a compact 12-byte record");
 
 struct UnknownTokens {
-    std::string value;
-    int line_no;
-    int col_no;
+    uint32_t lexeme;
+    uint32_t offset;
+    uint16_t file = 0;
 };
 
+// Walks the scanner's token vectors in place (no copy), yielding unknown tokens last
 class TokenIterator {
 private:
-    std::vector<Tokens> tokens;
-    std::vector<UnknownTokens> unknown_tokens;
+    const std::vector<Tokens>& tokens;
+    const std::vector<UnknownTokens>& unknown_tokens;
     size_t token_index;
     size_t unknown_token_index;
     Tokens temp_token; // For converting UnknownTokens to Tokens
@@ -37,13 +60,14 @@ public:
         return token_index < tokens.size() || unknown_token_index < unknown_tokens.size();
     }
 
-    Tokens* next() {
+    const Tokens* next() {
         if (is_unknown_token()) {
             const auto& ut = unknown_tokens[unknown_token_index++];
-            temp_token.type = "Unknown";
-            temp_token.value = ut.value;
-            temp_token.line_no = ut.line_no;
-            temp_token.col_no = ut.col_no;
+            temp_token.kind = TokenKind::Unknown;
+            temp_token.lexeme = ut.lexeme;
+            temp_token.offset = ut.offset;
+            temp_token.flags = 0;
+            temp_token.file = ut.file;
             return &temp_token;
         }
         if (token_index < tokens.size()) {
@@ -0,0 +1,84 @@
+#ifndef TOKEN_STREAM_HPP
+#define TOKEN_STREAM_HPP
+
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "token_iterator.hpp"
+#include "lexer.h"
+
+// Fixed-capacity FIFO between the scanner and whoever consumes its tokens.
+// The capacity is a power of two so positions wrap with a mask. An #include expands into a whole
+// header's tokens in one scanner action; what does not fit waits in overflow, and the ring counts
+// as full until that has drained.
+class TokenRing {
+private:
+    std::vector<Tokens> slots;
+    size_t mask;
+    size_t head = 0;  // Next token to pop
+    size_t count = 0;
+    std::deque<Tokens> overflow; // Tokens pushed after the ring filled, in order
+
+public:
+    static constexpr size_t kDefaultCapacity = 4096; // 48 KiB of tokens
+
+    explicit TokenRing(size_t capacity = kDefaultCapacity) : slots(capacity), mask(capacity - 1) {}
+
+    bool empty() const { return count == 0 && overflow.empty(); }
+    bool full() const { return count == slots.size() || !overflow.empty(); }
+    size_t size() const { return count + overflow.size(); }
+    size_t capacity() const { return slots.size(); }
+
+    // The scanner yields as soon as the ring is full, so only an #include expansion overflows it
+    void push(const Tokens& token) {
+        if (full()) {
+            overflow.push_back(token);
+            return;
+        }
+        slots[(head + count) & mask] = token;
+        count++;
+    }
+
+    Tokens pop() {
+        if (count == 0) {
+            Tokens token = overflow.front();
+            overflow.pop_front();
+            return token;
+        }
+        Tokens token = slots[head];
+        head = (head + 1) & mask;
+        count--;
+        return token;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        overflow.clear();
+    }
+};
+
+// Pulls tokens from the scanner on demand instead of lexing the whole file up front.
+// While a stream is open the scanner emits into FrontendContext::token_ring and returns
+// from yylex() whenever the ring fills, so peak token memory is the ring, not the file.
+class TokenStream {
+private:
+    FrontendContext& ctx;
+    yyscan_t scanner = nullptr;
+    FILE* input = nullptr;
+    bool exhausted = false;
+    Tokens current;
+
+public:
+    explicit TokenStream(FrontendContext& context) : ctx(context) {}
+    ~TokenStream() { close(); }
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator=(const TokenStream&) = delete;
+
+    bool open(const char* filename);
+    void close();
+    // Next token in source order (unknown tokens included, in place); nullptr at end of input
+    const Tokens* next();
+};
+
+#endif // TOKEN_STREAM_HPP
@@ -0,0 +1,72 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstring>
+#include <iostream>
+
+// Debug tracing for the hot paths (per token, per grammar rule, per AST line).
+// Quiet unless --verbose/--trace is given; levels above UCTOOL_TRACE_MAX_LEVEL
+// are discarded at compile time, so a release build carries no trace code at all.
+enum class TraceLevel : int {
+    Quiet = 0,
+    Info = 1,   // Occasional events (skipped directives, unknown tokens)
+    Debug = 2   // One line per token / rule / AST line
+};
+
+enum class TraceCategory : unsigned {
+    Lexer = 1u << 0,
+    Parser = 1u << 1,
+    AST = 1u << 2
+};
+
+#ifndef UCTOOL_TRACE_MAX_LEVEL
+#define UCTOOL_TRACE_MAX_LEVEL 2
+#endif
+
+inline constexpr unsigned kAllTraceCategories = 0x7;
+
+struct TraceConfig {
+    TraceLevel level = TraceLevel::Quiet;
+    unsigned categories = kAllTraceCategories;
+};
+
+// Set once from the command line before any stage runs
+inline TraceConfig trace_config;
+
+inline bool trace_enabled(TraceLevel level, TraceCategory category) {
+    return static_cast<int>(level) <= static_cast<int>(trace_config.level)
+        && (trace_config.categories & static_cast<unsigned>(category)) != 0;
+}
+
+// Parses a comma-separated category list ("lexer,parser,ast"); false on an unknown name
+inline bool parse_trace_categories(const char* list, unsigned& categories) {
+    categories = 0;
+    while (*list) {
+        size_t length = std::strcspn(list, ",");
+        if (length == 5 && std::strncmp(list, "lexer", 5) == 0) {
+            categories |= static_cast<unsigned>(TraceCategory::Lexer);
+        } else if (length == 6 && std::strncmp(list, "parser", 6) == 0) {
+            categories |= static_cast<unsigned>(TraceCategory::Parser);
+        } else if (length == 3 && std::strncmp(list, "ast", 3) == 0) {
+            categories |= static_cast<unsigned>(TraceCategory::AST);
+        } else {
+            return false;
+        }
+        list += length;
+        if (*list == ',') ++list;
+    }
+    return categories != 0;
+}
+
+// MESSAGE is a stream expression, e.g. UC_TRACE(TraceLevel::Debug, TraceCategory::Lexer, "Int: " << text);
+// it is only evaluated when the level and category are enabled. No flush: trace lines are buffered.
+#define UC_TRACE(LEVEL, CATEGORY, MESSAGE) \
+    do { \
+        if constexpr (static_cast<int>(LEVEL) <= UCTOOL_TRACE_MAX_LEVEL) { \
+            if (trace_enabled(LEVEL, CATEGORY)) { \
+                std::cout << MESSAGE << '\n'; \
+            } \
+        } \
+    } while (0)
+
+#endif // TRACE_HPP
@@ -1 +1,203 @@
-// Tests tool execution logic
+// Tests tool execution logic: #ifdef/#ifndef/#else/#endif evaluation in the scanner and in headers
+// spliced from HeaderCache, checked against fixed token streams and diagnostics on every scan path
+// (FAST with the kernels, the pure flex DFA, and stdio refills).
+// Build and run with `make test`.
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/include/frontend_context.hpp"
+#include "../src/include/HeaderCache.h"
+
+extern bool lexSourceFile(FrontendContext& ctx, const char* filename);
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Token spellings in order; evaluated conditionals in brackets, so "[#else]" is a branch the
+// scanner took and "#else" one it reported as unexpected
+std::vector<std::string> spellings(const FrontendContext& ctx) {
+    std::vector<std::string> out;
+    for (const Tokens& token : ctx.tokens) {
+        std::string text(ctx.strings.view(token.lexeme));
+        out.push_back(token.flags & TokenFlagConditional ? "[" + text + "]" : text);
+    }
+    for (const UnknownTokens& token : ctx.unknown_tokens) {
+        out.push_back("unknown " + std::string(ctx.strings.view(token.lexeme)));
+    }
+    return out;
+}
+
+std::string joined(const std::vector<std::string>& tokens) {
+    std::string out;
+    for (const std::string& token : tokens) {
+        out += (out.empty() ? "" : " | ") + token;
+    }
+    return out;
+}
+
+struct ScanPath {
+    const char* name;
+    bool mapSource;
+    bool useScanKernels;
+};
+
+constexpr ScanPath kScanPaths[] = {
+    {"fast", true, true},
+    {"pure flex", true, false},
+    {"stdio", false, false},
+};
+
+struct Case {
+    const char* name;
+    std::string source;
+    std::vector<std::string> tokens;
+    std::string diagnostics; // Everything written to std::cerr while lexing
+};
+
+// Lexes path on every scan path with no macros defined beforehand and compares each result
+bool expect(const Case& test, const fs::path& path) {
+    std::ofstream(path, std::ios::binary) << test.source;
+    bool passed = true;
+    for (const ScanPath& scan : kScanPaths) {
+        FrontendContext ctx;
+        ctx.lex_jobs = 1;
+        ctx.map_source = scan.mapSource;
+        ctx.use_scan_kernels = scan.useScanKernels;
+        std::ostringstream diagnostics;
+        std::streambuf* saved = std::cerr.rdbuf(diagnostics.rdbuf());
+        bool lexed = lexSourceFile(ctx, path.string().c_str());
+        std::cerr.rdbuf(saved);
+
+        std::vector<std::string> tokens = spellings(ctx);
+        if (!lexed || tokens != test.tokens || diagnostics.str() != test.diagnostics) {
+            std::cerr << "FAIL " << test.name << " (" << scan.name << ")\n"
+                      << "  expected: " << joined(test.tokens) << "\n"
+                      << "  got:      " << joined(tokens) << "\n"
+                      << "  expected diagnostics: " << test.diagnostics
+                      << "  got diagnostics:      " << diagnostics.str();
+            passed = false;
+        }
+    }
+    std::cout << (passed ? "ok   " : "FAIL ") << test.name << "\n";
+    return passed;
+}
+
+std::vector<Case> sourceCases() {
+    return {
+        {"nested #ifdef inside an inactive branch",
+         "#ifdef A\n"
+         "#ifdef B\n"
+         "int b;\n"
+         "#else\n"
+         "int nb;\n"
+         "#endif\n"
+         "int a;\n"
+         "#else\n"
+         "int na;\n"
+         "#endif\n"
+         "int z;\n",
+         {"[#ifdef A]", "[#else]", "int", "na", ";", "[#endif]", "int", "z", ";"},
+         ""},
+        {"#else after a taken first branch",
+         "#define A\n"
+         "#ifdef A\n"
+         "int a;\n"
+         "#else\n"
+         "int na;\n"
+         "#ifdef A\n"
+         "int nested;\n"
+         "#endif\n"
+         "#endif\n"
+         "int z;\n",
+         {"#define A", "[#ifdef A]", "int", "a", ";", "[#else]", "[#endif]", "int", "z", ";"},
+         ""},
+        {"#ifndef of a defined name",
+         "#define A\n"
+         "#ifndef A\n"
+         "int a;\n"
+         "#else\n"
+         "int na;\n"
+         "#endif\n",
+         {"#define A", "[#ifndef A]", "[#else]", "int", "na", ";", "[#endif]"},
+         ""},
+        {"unexpected #endif and #else",
+         "int a;\n"
+         "#endif\n"
+         "#else\n"
+         "int b;\n",
+         {"int", "a", ";", "#endif", "#else", "int", "b", ";"},
+         "Unexpected #endif at line 2\n"
+         "Unexpected #else at line 3\n"},
+        {"second #else of one conditional",
+         "#ifdef A\n"
+         "int a;\n"
+         "#else\n"
+         "int b;\n"
+         "#else\n"
+         "int c;\n"
+         "#endif\n",
+         {"[#ifdef A]", "[#else]", "int", "b", ";", "#else", "int", "c", ";", "[#endif]"},
+         "Unexpected #else at line 5\n"},
+        {"missing #endif at end of file",
+         "int a;\n"
+         "#ifdef A\n"
+         "int b;\n",
+         {"int", "a", ";", "[#ifdef A]"},
+         "Missing #endif for the conditional at line 2\n"},
+    };
+}
+
+// Headers are lexed with their conditionals as written and evaluated as they are spliced in, against
+// the macros of the including file (spliceHeader in HeaderCache.cpp)
+Case headerCase(const fs::path& dir) {
+    std::ofstream(dir / "cond.h", std::ios::binary) << "#ifdef A\n"
+                                                     << "int ha;\n"
+                                                     << "#ifdef B\n"
+                                                     << "int hab;\n"
+                                                     << "#endif\n"
+                                                     << "#else\n"
+                                                     << "int hna;\n"
+                                                     << "#endif\n"
+                                                     << "#ifndef A\n"
+                                                     << "int hn;\n"
+                                                     << "#else\n"
+                                                     << "int hy;\n"
+                                                     << "#endif\n"
+                                                     << "#endif\n";
+    std::ofstream(dir / "open.h", std::ios::binary) << "int ho;\n"
+                                                     << "#ifdef B\n"
+                                                     << "int hb;\n";
+    std::string cond = fs::canonical(dir / "cond.h").string();
+    std::string open = fs::canonical(dir / "open.h").string();
+    return {"conditionals in included headers",
+            "#define A\n"
+            "#include \"cond.h\"\n"
+            "#include \"open.h\"\n"
+            "int z;\n",
+            {"#define A", "#include \"cond.h\"", "[#ifdef A]", "int", "ha", ";", "[#ifdef B]", "[#endif]",
+             "[#else]", "[#endif]", "[#ifndef A]", "[#else]", "int", "hy", ";", "[#endif]",
+             "#include \"open.h\"", "int", "ho", ";", "[#ifdef B]", "int", "z", ";"},
+            "Error: Unexpected #endif in " + cond + " at line 14\n"
+            "Error: Missing #endif in " + open + " for the conditional at line 2\n"};
+}
+
+} // namespace
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / "uctool-test-conditionals";
+    fs::create_directories(dir);
+    HeaderCache::shared().clear();
+
+    bool passed = true;
+    for (const Case& test : sourceCases()) {
+        passed = expect(test, dir / "case.c") && passed;
+    }
+    passed = expect(headerCase(dir), dir / "main.c") && passed;
+
+    fs::remove_all(dir);
+    return passed ? 0 : 1;
+}